@@ -0,0 +1,40 @@
+#include "Arduino.h"
+
+/* Virtual clock and pin state behind the host Arduino.h stand-in*/
+static thread_local unsigned long long hostMicros = 0;
+thread_local uint8_t hostPinLevel[HOST_PINS];
+
+unsigned long millis ( void ) {
+    return (unsigned long) ( hostMicros / 1000 );
+}
+
+unsigned long micros ( void ) {
+    return (unsigned long) hostMicros;
+}
+
+void hostAdvanceMicros ( unsigned long us ) {
+    hostMicros += us;
+}
+
+void hostSetMicros ( unsigned long long us ) {
+    hostMicros = us;
+}
+
+int digitalRead ( uint8_t pin ) {
+    return ( pin < HOST_PINS ) ? hostPinLevel[pin] : LOW;
+}
+
+void digitalWrite ( uint8_t pin, uint8_t value ) {
+    if( pin < HOST_PINS ){
+        hostPinLevel[pin] = value ? HIGH : LOW;
+    }
+}
+
+void pinMode ( uint8_t pin, uint8_t mode ) {
+    (void) pin;
+    (void) mode;
+}
+
+long map ( long value, long fromLow, long fromHigh, long toLow, long toHigh ) {
+    return ( value - fromLow ) * ( toHigh - toLow ) / ( fromHigh - fromLow ) + toLow;
+}
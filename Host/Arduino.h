@@ -0,0 +1,64 @@
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+/* Minimal stand-in for the Arduino core so the task modules in StarterFile/
+ * can be compiled and exercised on a Linux host. Time is virtual: it only
+ * moves when a host program calls hostAdvanceMicros(), which keeps
+ * simulations deterministic and lets them run faster than real time.
+ * The clock and the pins belong to the calling thread, so a host program
+ * can run independent boards on several threads at once.*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0
+#define OUTPUT  1
+
+#ifdef __cplusplus
+#define HOST_THREAD_LOCAL thread_local
+#else
+#define HOST_THREAD_LOCAL _Thread_local
+#endif
+
+#define HOST_PINS 70                                    // Arduino Mega pin count
+
+#define A0  54                                          // Arduino Mega analog pin numbers
+#define A1  55
+#define A2  56
+#define A3  57
+#define A4  58
+#define A5  59
+
+#define PROGMEM                                         // Flash tables are ordinary constants on the host
+#define pgm_read_word(address)  ( *(const uint16_t*) (address) )
+
+#define DEC 10
+#define HEX 16
+
+unsigned long millis (void);
+unsigned long micros (void);
+void hostAdvanceMicros (unsigned long us);              // Move the virtual clock forward
+void hostSetMicros (unsigned long long us);             // Set the clock, for a board that moves between threads
+
+int digitalRead (uint8_t pin);
+void digitalWrite (uint8_t pin, uint8_t value);
+void pinMode (uint8_t pin, uint8_t mode);
+long map (long value, long fromLow, long fromHigh, long toLow, long toHigh);
+extern HOST_THREAD_LOCAL uint8_t hostPinLevel[HOST_PINS];   // Pin levels, written by the program or by a simulator
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // HOST_ARDUINO_H_
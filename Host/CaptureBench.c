@@ -0,0 +1,309 @@
+/* Host check and benchmark of the burst capture in StarterFile/Capture.c
+ *
+ * Runs the measurement task of one board on the virtual clock with a pack
+ * that trips over current, trips again while the first capture is still
+ * being stored, and later opens the interlock. Captures go to a file that
+ * takes only a few bytes per call and a pass more to finish, the way a
+ * busy SD card does, and are read back and checked: header, the trigger
+ * sample being the first one outside the limits, the pre and post trigger
+ * counts, stamps in order and every current as the pack gave it. The same
+ * run is repeated with a one capture slot that, like the EEPROM, keeps
+ * its capture until it is cleared: the first trip must stay in it and the
+ * later ones count as missed without a byte written.
+ * The steady state is checked to touch nothing but the one ring slot, the
+ * head and the fill count per sample, and the cost of a sample is timed;
+ * the host time is only a rough guide to the AVR's.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -c -IHost Host/Arduino.cpp -o /tmp/Arduino.o
+ *   gcc -O2 -IHost -IStarterFile Host/CaptureBench.c StarterFile/Capture.c \
+ *       StarterFile/Measurement.c StarterFile/Statistics.c StarterFile/History.c \
+ *       -x c++ StarterFile/Gpio.cpp -x none /tmp/Arduino.o -lm -lstdc++ -o /tmp/CaptureBench
+ *   /tmp/CaptureBench [capture file, default /tmp/capture.bin]
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "Arduino.h"
+#include "Measurement.h"
+#include "Alarm.h"
+#include "Capture.h"
+
+#define RUN_SECONDS     12UL        // Simulated seconds
+#define STEP_US         500UL       // One scheduler pass
+#define WRITE_BYTES     5           // Most bytes the file storage takes per call
+#define TIMED_SAMPLES   10000000UL  // recordCapture calls timed in the steady state
+
+/* The pack: 20 A with a little ripple, over current from 5 s to 5.05 s and
+ * again from 5.08 s, while the first capture is being stored, to 5.2 s.
+ * The interlock opens at 8 s.*/
+#define TRIP_US         5000000UL
+#define TRIP_END_US     5050000UL
+#define RETRIP_US       5080000UL
+#define RETRIP_END_US   5200000UL
+#define HVIL_OPEN_US    8000000UL
+#define EXPECTED        2           // Captures: the first over current and the interlock
+#define END_POLLS       2           // Calls the file storage needs to finish a capture
+#define CAPTURE_BYTES   ( sizeof(captureHeader) + CAPTURE_SAMPLES * sizeof(captureSample) )
+
+static float packCurrent ( unsigned long us ) {
+    if( ( us >= TRIP_US && us < TRIP_END_US ) || ( us >= RETRIP_US && us < RETRIP_END_US ) ){
+        return 40.0;
+    }
+    return 20.0 + 2.0 * sin(us * 1e-5);
+}
+
+static bool benchHvil ( void* context ) {
+    (void) context;
+    return micros() >= HVIL_OPEN_US ? HVIL_OPEN : HVIL_CLOSED;
+}
+
+static float benchCurrent ( void* context ) {
+    (void) context;
+    return packCurrent(micros());
+}
+
+static float benchVoltage ( void* context ) {
+    (void) context;
+    return 380.0;
+}
+
+static float benchTemperature ( void* context ) {
+    (void) context;
+    return 25.0;
+}
+
+static const sensorSource benchSensors = { benchHvil, benchCurrent, benchVoltage, benchTemperature };
+
+/* File stand in for EEPROM, SPI flash or an SD card, captures one after
+ * another*/
+static FILE* file;
+static unsigned int fileExpected, fileWritten, fileCalls, fileEnds;
+static bool fileOpen, fileShort;
+
+static bool fileBegin ( unsigned int length ) {
+    fileExpected = length;
+    fileWritten  = 0;
+    fileEnds     = 0;
+    fileOpen     = true;
+    return true;
+}
+
+static unsigned int fileWrite ( const byte* data, unsigned int length ) {
+    fileCalls++;
+    if( length > WRITE_BYTES ){
+        length = WRITE_BYTES;
+    }
+    fwrite(data, 1, length, file);
+    fileWritten += length;
+    return length;
+}
+
+static bool fileEnd ( void ) {
+    if( ++fileEnds < END_POLLS ){
+        return false;
+    }
+    fflush(file);
+    fileShort = fileShort || fileWritten != fileExpected;
+    fileOpen  = false;
+    return true;
+}
+
+static const captureStorage fileStorage = { fileBegin, fileWrite, fileEnd };
+
+/* One capture slot kept until it is cleared, the EEPROM's behaviour, a
+ * byte per call*/
+static byte slot[CAPTURE_BYTES];
+static unsigned int slotWritten, slotCalls;
+static bool slotHeld;
+
+static bool slotBegin ( unsigned int length ) {
+    if( slotHeld || length > sizeof(slot) ){
+        return false;
+    }
+    slotWritten = 0;
+    return true;
+}
+
+static unsigned int slotWrite ( const byte* data, unsigned int length ) {
+    slotCalls++;
+    if( length == 0 ){
+        return 0;
+    }
+    slot[slotWritten++] = data[0];
+    return 1;
+}
+
+static bool slotEnd ( void ) {
+    slotHeld = true;
+    return true;
+}
+
+static const captureStorage slotStorage = { slotBegin, slotWrite, slotEnd };
+
+/* One board, wired the way setup() wires it*/
+static bool hVIL = HVIL_CLOSED;
+static float temperature, hvCurrent, hvVoltage;
+static channelStats currentStats, voltageStats;
+static trendHistory history;
+static channelTable channels;
+static byte clockTick;
+static captureBuffer capture;
+static measurementData measure;
+
+static double nowSeconds ( void ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool outsideLimits ( const captureSample* sample, byte cause ) {
+    if( cause & CAPTURE_OVER_CURRENT ){
+        float current = sample->current / CAPTURE_CURRENT_SCALE;
+        return current < CURRENT_MIN || current > CURRENT_MAX;
+    }
+    return ( sample->stamp & 1 ) == HVIL_OPEN;
+}
+
+/* Checks one capture read back from the file, prints it and returns
+ * whether it is right*/
+static bool checkCapture ( unsigned int n, const captureHeader* header, const captureSample* samples ) {
+    bool ok = true;
+    float worst = 0;
+    unsigned int trigger = header->pre - 1;
+
+    printf("capture %u: cause %s, %u samples, %u before the trigger, trigger at %.6f s, %u missed\n", n,
+           header->cause == CAPTURE_OVER_CURRENT ? "over current" : header->cause == CAPTURE_HVIL_OPEN ? "HVIL open" : "?",
+           header->samples, header->pre, header->trigger * 1e-6, header->missed);
+    printf("           %.6f s to %.6f s, %.1f A and %s at the trigger\n",
+           ( samples[0].stamp & ~1UL ) * 1e-6, ( samples[header->samples - 1].stamp & ~1UL ) * 1e-6,
+           samples[trigger].current / CAPTURE_CURRENT_SCALE,
+           ( samples[trigger].stamp & 1 ) == HVIL_OPEN ? "HVIL open" : "HVIL closed");
+
+    ok = ok && header->magic == CAPTURE_MAGIC && header->version == CAPTURE_VERSION;
+    ok = ok && header->pre == CAPTURE_PRE && header->samples == CAPTURE_SAMPLES;
+    ok = ok && ( samples[trigger].stamp & ~1UL ) == header->trigger;
+    ok = ok && outsideLimits(&samples[trigger], header->cause) && !outsideLimits(&samples[trigger - 1], header->cause);
+    for( unsigned int i = 0; i < header->samples; i++ ){
+        if( i > 0 && ( samples[i].stamp & ~1UL ) <= ( samples[i - 1].stamp & ~1UL ) ){
+            printf("           stamps out of order at sample %u\n", i);
+            ok = false;
+        }
+        worst = fmax(worst, fabs(samples[i].current / CAPTURE_CURRENT_SCALE - packCurrent(samples[i].stamp & ~1UL)));
+    }
+    printf("           worst current against the pack %.4f A\n", worst);
+    return ok && worst <= 1.0 / CAPTURE_CURRENT_SCALE;
+}
+
+/* Feeds steady samples straight to an armed ring and checks each changed
+ * nothing but its slot, the head and the fill count. Returns ns per sample.*/
+static double steadyState ( bool* touched ) {
+    static captureBuffer before;
+    captureBuffer* buffer = &capture;
+    double start;
+
+    initCapture(buffer, &fileStorage);
+    *touched = false;
+    for( unsigned int i = 0; i < 4 * CAPTURE_SAMPLES; i++ ){
+        byte slot = buffer->head % CAPTURE_SAMPLES;
+        memcpy(&before, buffer, sizeof(before));
+        recordCapture(buffer, i * CURRENT_PERIOD, 20.0, 380.0, HVIL_CLOSED);
+        before.ring[slot] = buffer->ring[slot];
+        before.head       = buffer->head;
+        before.filled     = buffer->filled;
+        if( memcmp(&before, buffer, sizeof(before)) != 0 ){
+            *touched = true;
+        }
+    }
+
+    start = nowSeconds();
+    for( unsigned long i = 0; i < TIMED_SAMPLES; i++ ){
+        recordCapture(buffer, i, 20.0 + ( i & 7 ), 380.0, HVIL_CLOSED);
+    }
+    return ( nowSeconds() - start ) * 1e9 / TIMED_SAMPLES;
+}
+
+/* Runs the board for RUN_SECONDS with captures going to storage. Returns
+ * the most storage writes in one pass.*/
+static unsigned int runBoard ( const captureStorage* storage, unsigned int* writes ) {
+    unsigned int longest = 0;
+
+    *writes = 0;
+    hostSetMicros(0);
+    initChannelStats(&currentStats, millis());
+    initChannelStats(&voltageStats, millis());
+    initMeasurementChannels(&channels, micros());
+    initCapture(&capture, storage);
+    measure = (measurementData) { &hVIL, &temperature, &hvCurrent, &hvVoltage,
+                                  &currentStats, &voltageStats, &history, &channels,
+                                  &clockTick, &benchSensors, &measure, &capture };
+
+    for( unsigned long us = 0; us < RUN_SECONDS * 1000000UL; us += STEP_US ){
+        unsigned int calls = fileCalls + slotCalls;
+        measurementTask(&measure);
+        captureTask(&capture);
+        if( fileCalls + slotCalls != calls ){
+            ( *writes )++;
+        }
+        if( fileCalls + slotCalls - calls > longest ){
+            longest = fileCalls + slotCalls - calls;
+        }
+        hostAdvanceMicros(STEP_US);
+    }
+    return longest;
+}
+
+int main ( int argc, char** argv ) {
+    const char* path = ( argc > 1 ) ? argv[1] : "/tmp/capture.bin";
+    captureHeader header;
+    captureSample samples[CAPTURE_SAMPLES];
+    unsigned int found = 0, longest, writes;
+    unsigned long storing;
+    bool pass = true, touched;
+    double perSample;
+
+    file = fopen(path, "wb");
+    if( file == NULL ){
+        printf("could not write %s\n", path);
+        return 1;
+    }
+    longest = runBoard(&fileStorage, &writes);
+    storing = writes * STEP_US;
+    fclose(file);
+
+    printf("%lu simulated seconds, %u captures stored, %u missed, %u passes spent storing (%.1f ms), "
+           "at most %u write per pass\n\n", RUN_SECONDS, capture.captures, capture.missed, writes,
+           storing * 1e-3, longest);
+    pass = pass && capture.captures == EXPECTED && capture.missed == 1 && longest <= 1 && !fileOpen && !fileShort;
+
+    file = fopen(path, "rb");
+    while( file != NULL && fread(&header, sizeof(header), 1, file) == 1 ){
+        if( header.samples > CAPTURE_SAMPLES || fread(samples, sizeof(captureSample), header.samples, file) != header.samples ){
+            printf("capture %u is cut short\n", found);
+            pass = false;
+            break;
+        }
+        pass = checkCapture(found, &header, samples) && pass;
+        found++;
+    }
+    if( file != NULL ){
+        fclose(file);
+    }
+    pass = pass && found == EXPECTED;
+
+    runBoard(&slotStorage, &writes);
+    memcpy(&header, slot, sizeof(header));
+    memcpy(samples, slot + sizeof(header), sizeof(samples));
+    printf("\none capture slot: %u stored, %u missed, %u bytes written\n", capture.captures, capture.missed, slotWritten);
+    pass = pass && capture.captures == 1 && capture.missed == EXPECTED && slotWritten == CAPTURE_BYTES;
+    pass = checkCapture(0, &header, samples) && header.cause == CAPTURE_OVER_CURRENT && pass;
+
+    perSample = steadyState(&touched);
+    printf("\nsteady state: %s outside the slot, head and fill count, %.2f ns per sample\n",
+           touched ? "WROTE" : "nothing written", perSample);
+    pass = pass && !touched;
+
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+/* Host render cost report for StarterFile/Display.cpp
+ *
+ * Display.cpp is linked against the Elegoo_TFTLCD stand-in in Host/, which
+ * counts every address window, pixel, fill and bus byte the AVR library would
+ * send to an ILI9341 shield and turns them into AVR cycles. Each drawing path
+ * is run on its own and its cost is compared with a budget; a path that got
+ * more expensive than its budget fails the run. A frame is one displayTask
+ * call, one scheduler pass, so screen switches report both the whole redraw
+ * and the worst slice. The screen the panel would show after each step is
+ * written out as a PPM image for a visual check.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -IHost -IStarterFile -x c++ Host/DisplayBench.cpp StarterFile/Display.cpp \
+ *       Host/Elegoo_TFTLCD.cpp Host/Elegoo_GFX.cpp Host/Arduino.cpp \
+ *       -x c StarterFile/History.c StarterFile/Latency.c StarterFile/Diagnostics.c -o /tmp/DisplayBench
+ *   /tmp/DisplayBench [image directory, default /tmp]
+ */
+#include <stdio.h>
+#include <string.h>
+#include "Arduino.h"
+#include "Display.h"
+#include "TaskControlBlock.h"
+
+/* Cycle budgets, a little above the current cost of each path*/
+#define BUDGET_BOOT             660000UL
+#define BUDGET_BUTTON           140000UL
+#define BUDGET_BUTTON_BAR       560000UL
+#define BUDGET_SWITCH_MEASURE   900000UL
+#define BUDGET_SWITCH_ALARM     960000UL
+#define BUDGET_SWITCH_BATTERY   860000UL
+#define BUDGET_SWITCH_TREND     1150000UL
+#define BUDGET_SLICE            400000UL     // Worst single pass of any screen switch
+#define BUDGET_MEASURE_IDLE     29000UL
+#define BUDGET_MEASURE_ALL      155000UL
+#define BUDGET_ALARM_ALL        270000UL
+#define BUDGET_BATTERY_TOGGLE   19000UL
+#define BUDGET_TREND_SAMPLE     3800UL
+#define BUDGET_BATTERY_BUTTONS  230000UL
+#define BUDGET_SWITCH_DIAG      1500000UL    // Labels and the first update, every value drawn
+#define BUDGET_DIAG_SECOND      120000UL     // A typical second: a few task times moved
+
+/* Globals the sketch owns and Display.cpp reaches with extern*/
+Elegoo_TFTLCD tft(0, 0, 0, 0, 0);
+TouchScreen ts(XP, YP, XM, YM, 300);
+byte currentScreen = MEASURE;
+
+bool measureButton = 0;
+bool alarmButton = 0;
+bool batteryButton = 0;
+bool trendButton = 0;
+bool diagnosticsButton = 0;
+
+Elegoo_GFX_Button buttons[SCREEN_BUTTONS];
+char buttonlabels[SCREEN_BUTTONS][9] = {"Measure", "Alarms", "Battery", "Trend", "Diag"};
+uint16_t buttoncolors[SCREEN_BUTTONS] = {CYAN, CYAN, CYAN, CYAN, CYAN};
+Elegoo_GFX_Button batteryButtons[2];
+char batteryButtonLabels[2][4] = {"OFF", "ON"};
+Elegoo_GFX_Button alarmAckButton;
+char alarmAckLabel[4] = "ACK";
+
+float hvCurrent = 0;
+float hvVoltage = 0;
+float temperature = 0;
+bool hVIL = 0;
+byte hVoltInterlock = 0;
+byte overCurrent = 0;
+byte hVoltOutofRange = 0;
+float stateOfCharge = 0;
+bool contactorState = 0;
+bool contactorAck = 0;
+trendHistory history;
+uint16_t lcdIdentifier = 0x9341;
+channelTable channels;
+latencyTrace latency;
+unsigned long alarmStamp = 0;
+float currentTimeToLimit = TREND_NEVER;
+float voltageTimeToLimit = TREND_NEVER;
+unsigned long contactorStamp = 0;
+bool alarmAcknowledge = 0;
+schedulerStats scheduler;
+telemetryQueue telemetryFrames;
+static TCB benchTasks[TASK_COUNT - 1];
+static TCB displayTCB;
+TCB* allTasks[TASK_COUNT] = {&benchTasks[0], &benchTasks[1], &benchTasks[2], &benchTasks[3],
+                             &benchTasks[4], &benchTasks[5], &benchTasks[6], &displayTCB};
+
+/* Display.cpp functions that are not in Display.h*/
+void batteryButtonDisplay ();
+void updateMeasurementDisplay ();
+void updateAlarmDisplay ();
+void updateBatteryDisplay ( bool* contactorState );
+void updateTrendDisplay ();
+static displayData display;
+static const char* imageDirectory = "/tmp";
+static int failures = 0;
+
+/* Prints one line of the report and checks it against its budget*/
+static void report ( const char* path, const lcdBusStats* stats, unsigned long cycles, unsigned long budget ) {
+    bool over = cycles > budget;
+
+    printf("%-26s %7lu %7lu %6lu %9lu %9lu %10lu %8.2f %s\n", path,
+           stats->calls, stats->addressWindows, stats->fills, stats->filledPixels,
+           stats->busWrites + stats->busStrobes, cycles, cycles / ( TFT_CPU_MHZ * 1000.0 ),
+           over ? "OVER BUDGET" : "ok");
+    if( over ){
+        printf("%-26s budget is %lu cycles\n", "", budget);
+        failures++;
+    }
+}
+
+static void measure ( const char* path, void (*draw)(void), unsigned long budget ) {
+    tft.resetStats();
+    draw();
+    report(path, &tft.stats, lcdBusCycles(&tft.stats), budget);
+}
+
+static void saveImage ( const char* name ) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/display_%s.ppm", imageDirectory, name);
+    if( !tft.writePPM(path) ){
+        printf("could not write %s\n", path);
+        failures++;
+    }
+}
+
+/* Flags a screen, if flag is given, and runs the display task until the
+ * redraw is finished*/
+static void switchScreen ( const char* path, bool* flag, unsigned long budget, const char* image ) {
+    lcdBusStats total;
+    unsigned long worst = 0;
+    unsigned long passes = 0;
+
+    memset(&total, 0, sizeof(total));
+    if( flag != NULL ){
+        *flag = true;
+    }
+    do {
+        tft.resetStats();
+        displayTCB.task(displayTCB.taskDataPtr);
+        hostAdvanceMicros(1000);
+        total.calls          += tft.stats.calls;
+        total.addressWindows += tft.stats.addressWindows;
+        total.fills          += tft.stats.fills;
+        total.filledPixels   += tft.stats.filledPixels;
+        total.busWrites      += tft.stats.busWrites;
+        total.busStrobes     += tft.stats.busStrobes;
+        if( lcdBusCycles(&tft.stats) > worst ){
+            worst = lcdBusCycles(&tft.stats);
+        }
+        passes++;
+    } while( PT_RUNNING(&displayTCB.thread) );
+
+    report(path, &total, lcdBusCycles(&total), budget);
+    printf("%-26s %lu passes, worst pass %lu cycles\n", "", passes, worst);
+    if( worst > BUDGET_SLICE ){
+        printf("%-26s worst pass over the %lu cycle slice budget\n", "", BUDGET_SLICE);
+        failures++;
+    }
+    saveImage(image);
+}
+
+/* Drawing paths*/
+static void boot ( void ) {
+    tft.reset();
+    tft.begin(tft.readID());
+    tft.setRotation(2);
+    tft.fillScreen(BLACK);
+}
+
+static void firstButton ( void ) {
+    buttons[0].drawButton();
+}
+
+static void buttonBar ( void ) {
+    for( uint8_t row = 0; row < SCREEN_BUTTONS; row++ ){
+        buttons[row].drawButton();
+    }
+}
+
+static void measureIdle ( void ) {
+    updateMeasurementDisplay();
+}
+
+static void measureAll ( void ) {
+    temperature += 1.5;
+    hvCurrent   -= 3.25;
+    hvVoltage   += 7.5;
+    hVIL         = !hVIL;
+    updateMeasurementDisplay();
+}
+
+static void alarmAll ( void ) {
+    hVoltInterlock  = 1;
+    overCurrent     = 2;
+    hVoltOutofRange = PRE_WARNING;
+    voltageTimeToLimit = 7.4;
+    currentTimeToLimit = 123.0;
+    updateAlarmDisplay();
+}
+
+static void batteryToggle ( void ) {
+    contactorState = !contactorState;
+    updateBatteryDisplay(&contactorState);
+}
+
+/* Task times of a scheduler second, the display's own included, with a
+ * little jitter so some of the values on the diagnostics screen move*/
+static void nextSecond ( void ) {
+    static const unsigned int average[TASK_COUNT] = { 14, 9, 11, 3, 180, 6, 95, 2100 };
+    static unsigned int step = 0;
+
+    step++;
+    for( byte i = 0; i < TASK_COUNT; i++ ){
+        allTasks[i]->stats.average = average[i] + ( ( step + i ) % 3 == 0 ? 4 : 0 );
+        allTasks[i]->stats.worst   = average[i] * 3 + ( i == 0 ? 4 * step : 0 );
+    }
+    allTasks[0]->stats.misses = step / 2;
+    scheduler.idle = 93;
+    telemetryFrames.count = step % 2;
+    telemetryFrames.deepest = 2;
+}
+
+static void trendSample ( void ) {
+    static unsigned int step = 0;
+    step++;
+    pushHistory(&history, 300 + 50 * sin(step * 0.05), 20 * cos(step * 0.07), 15 + 10 * sin(step * 0.02));
+    updateTrendDisplay();
+}
+
+int main ( int argc, char** argv ) {
+
+    if( argc > 1 ){
+        imageDirectory = argv[1];
+    }
+
+    memset(&history, 0, sizeof(history));
+    for( unsigned int i = 0; i < HISTORY_LENGTH; i++ ){
+        pushHistory(&history, 250 + 100 * sin(i * 0.05), 15 * sin(i * 0.11), 20 + 5 * cos(i * 0.03));
+    }
+    temperature    = 21.5;
+    hvCurrent      = 12.25;
+    hvVoltage      = 380.0;
+    stateOfCharge  = 0;
+
+    const char* names[TASK_COUNT - 1] = { "Measure", "Modules", "Telemetry", "Capture", "Charge", "Contactor", "Alarm" };
+    for( byte i = 0; i < TASK_COUNT - 1; i++ ){
+        benchTasks[i].name = names[i];
+    }
+    displayTCB.name = "Display";
+    nextSecond();
+
+    display.contactorState = &contactorState;
+    display.thread         = &displayTCB.thread;
+    displayTCB.task        = &displayTask;
+    displayTCB.taskDataPtr = &display;
+    PT_INIT(&displayTCB.thread);
+
+    printf("ILI9341 on the 8-bit shield, %d cycles per bus byte, %d per repeated strobe, %d per call\n\n",
+           TFT_CYCLES_PER_WRITE, TFT_CYCLES_PER_STROBE, TFT_CYCLES_PER_CALL);
+    printf("%-26s %7s %7s %6s %9s %9s %10s %8s\n", "path", "calls", "windows", "fills", "fill px",
+           "bus ops", "cycles", "ms");
+
+    measure("boot clear", boot, BUDGET_BOOT);
+    for( uint8_t row = 0; row < SCREEN_BUTTONS; row++ ){
+        buttons[row].initButton(&tft, BUTTON1_SPACING_X + row * BUTTON2_SPACING_X, BUTTON_Y,
+                                BUTTON_W, BUTTON_H, WHITE, buttoncolors[row], BLACK,
+                                buttonlabels[row], BUTTON_TEXTSIZE);
+    }
+    measure("button draw", firstButton, BUDGET_BUTTON);
+    measure("button bar", buttonBar, BUDGET_BUTTON_BAR);
+
+    switchScreen("switch to measurements", &measureButton, BUDGET_SWITCH_MEASURE, "measure");
+    measure("updateMeasurementDisplay", measureIdle, BUDGET_MEASURE_IDLE);
+    measure("  every value changed", measureAll, BUDGET_MEASURE_ALL);
+    saveImage("measure_updated");
+
+    switchScreen("switch to alarms", &alarmButton, BUDGET_SWITCH_ALARM, "alarm");
+    measure("updateAlarmDisplay", alarmAll, BUDGET_ALARM_ALL);
+    saveImage("alarm_updated");
+
+    switchScreen("switch to battery", &batteryButton, BUDGET_SWITCH_BATTERY, "battery");
+    measure("updateBatteryDisplay", batteryToggle, BUDGET_BATTERY_TOGGLE);
+    measure("battery buttons", batteryButtonDisplay, BUDGET_BATTERY_BUTTONS);
+    saveImage("battery_updated");
+
+    switchScreen("switch to trend", &trendButton, BUDGET_SWITCH_TREND, "trend");
+    measure("updateTrendDisplay", trendSample, BUDGET_TREND_SAMPLE);
+    for( unsigned int i = 0; i < HISTORY_LENGTH / 2; i++ ){
+        trendSample();
+    }
+    saveImage("trend_scrolled");
+
+    switchScreen("switch to diagnostics", &diagnosticsButton, BUDGET_SWITCH_DIAG, "diagnostics");
+    nextSecond();
+    switchScreen("updateDiagnosticsDisplay", NULL, BUDGET_DIAG_SECOND, "diagnostics_updated");
+
+    printf("\nimages in %s/display_*.ppm\n", imageDirectory);
+    if( failures ){
+        printf("%d paths over budget\n", failures);
+    }
+    return failures ? 1 : 0;
+}
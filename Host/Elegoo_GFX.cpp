@@ -0,0 +1,313 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "Elegoo_GFX.h"
+
+/* Classic 5x7 font, printable ASCII only. Each glyph is five columns with the
+ * top row in bit 0; characters outside 0x20-0x7E draw as a blank cell.*/
+static const uint8_t font[95][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A},
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+    {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+    {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+    {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E},
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00},
+    {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+    {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+    {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+    {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+    {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x10,0x08,0x08,0x10,0x08}
+};
+
+/* Print, formatted the way the Arduino core formats numbers*/
+size_t Print::write ( const uint8_t* buffer, size_t size ) {
+    size_t n = 0;
+    while( size-- ){
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print ( const char* text ) {
+    return write((const uint8_t*) text, strlen(text));
+}
+
+size_t Print::print ( char c ) {
+    return write((uint8_t) c);
+}
+
+size_t Print::print ( long value, int base ) {
+    char text[40];
+    if( base == HEX ){
+        snprintf(text, sizeof(text), "%lX", (unsigned long) value);
+    }
+    else {
+        snprintf(text, sizeof(text), "%ld", value);
+    }
+    return print(text);
+}
+
+size_t Print::print ( unsigned long value, int base ) {
+    char text[40];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+    return print(text);
+}
+
+size_t Print::print ( int value, int base ) {
+    return print((long) value, base);
+}
+
+size_t Print::print ( unsigned int value, int base ) {
+    return print((unsigned long) value, base);
+}
+
+size_t Print::print ( double value, int digits ) {
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    return print(text);
+}
+
+size_t Print::println ( void )                          { return print("\r\n"); }
+size_t Print::println ( const char* text )              { return print(text) + println(); }
+size_t Print::println ( int value, int base )           { return print(value, base) + println(); }
+size_t Print::println ( unsigned int value, int base )  { return print(value, base) + println(); }
+size_t Print::println ( long value, int base )          { return print(value, base) + println(); }
+size_t Print::println ( unsigned long value, int base ) { return print(value, base) + println(); }
+size_t Print::println ( double value, int digits )      { return print(value, digits) + println(); }
+
+/* Graphics primitives, same algorithms as the AVR library*/
+Elegoo_GFX::Elegoo_GFX ( int16_t w, int16_t h ) : WIDTH(w), HEIGHT(h) {
+    _width    = WIDTH;
+    _height   = HEIGHT;
+    rotation  = 0;
+    cursor_x  = cursor_y = 0;
+    textsize  = 1;
+    textcolor = textbgcolor = 0xFFFF;
+    wrap      = true;
+}
+
+void Elegoo_GFX::drawFastVLine ( int16_t x, int16_t y, int16_t h, uint16_t color ) {
+    drawLine(x, y, x, y + h - 1, color);
+}
+
+void Elegoo_GFX::drawFastHLine ( int16_t x, int16_t y, int16_t w, uint16_t color ) {
+    drawLine(x, y, x + w - 1, y, color);
+}
+
+void Elegoo_GFX::fillRect ( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color ) {
+    for( int16_t i = x; i < x + w; i++ ){
+        drawFastVLine(i, y, h, color);
+    }
+}
+
+void Elegoo_GFX::fillScreen ( uint16_t color ) {
+    fillRect(0, 0, _width, _height, color);
+}
+
+void Elegoo_GFX::drawLine ( int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color ) {
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    int16_t t;
+    if( steep ){
+        t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+    }
+    if( x0 > x1 ){
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    int16_t dx = x1 - x0, dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = ( y0 < y1 ) ? 1 : -1;
+    for( ; x0 <= x1; x0++ ){
+        if( steep ){
+            drawPixel(y0, x0, color);
+        }
+        else {
+            drawPixel(x0, y0, color);
+        }
+        err -= dy;
+        if( err < 0 ){
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+void Elegoo_GFX::drawRect ( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color ) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Elegoo_GFX::drawCircleHelper ( int16_t x0, int16_t y0, int16_t r, uint8_t corner, uint16_t color ) {
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    while( x < y ){
+        if( f >= 0 ){
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+        if( corner & 0x4 ){ drawPixel(x0 + x, y0 + y, color); drawPixel(x0 + y, y0 + x, color); }
+        if( corner & 0x2 ){ drawPixel(x0 + x, y0 - y, color); drawPixel(x0 + y, y0 - x, color); }
+        if( corner & 0x8 ){ drawPixel(x0 - y, y0 + x, color); drawPixel(x0 - x, y0 + y, color); }
+        if( corner & 0x1 ){ drawPixel(x0 - y, y0 - x, color); drawPixel(x0 - x, y0 - y, color); }
+    }
+}
+
+void Elegoo_GFX::fillCircleHelper ( int16_t x0, int16_t y0, int16_t r, uint8_t corner, int16_t delta, uint16_t color ) {
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    while( x < y ){
+        if( f >= 0 ){
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+        if( corner & 0x1 ){
+            drawFastVLine(x0 + x, y0 - y, 2 * y + 1 + delta, color);
+            drawFastVLine(x0 + y, y0 - x, 2 * x + 1 + delta, color);
+        }
+        if( corner & 0x2 ){
+            drawFastVLine(x0 - x, y0 - y, 2 * y + 1 + delta, color);
+            drawFastVLine(x0 - y, y0 - x, 2 * x + 1 + delta, color);
+        }
+    }
+}
+
+void Elegoo_GFX::drawRoundRect ( int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color ) {
+    drawFastHLine(x + r, y, w - 2 * r, color);
+    drawFastHLine(x + r, y + h - 1, w - 2 * r, color);
+    drawFastVLine(x, y + r, h - 2 * r, color);
+    drawFastVLine(x + w - 1, y + r, h - 2 * r, color);
+    drawCircleHelper(x + r, y + r, r, 1, color);
+    drawCircleHelper(x + w - r - 1, y + r, r, 2, color);
+    drawCircleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
+    drawCircleHelper(x + r, y + h - r - 1, r, 8, color);
+}
+
+void Elegoo_GFX::fillRoundRect ( int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color ) {
+    fillRect(x + r, y, w - 2 * r, h, color);
+    fillCircleHelper(x + w - r - 1, y + r, r, 1, h - 2 * r - 1, color);
+    fillCircleHelper(x + r, y + r, r, 2, h - 2 * r - 1, color);
+}
+
+void Elegoo_GFX::drawChar ( int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size ) {
+    if( x >= _width || y >= _height || x + 6 * size - 1 < 0 || y + 8 * size - 1 < 0 ){
+        return;
+    }
+    for( int8_t i = 0; i < 6; i++ ){
+        uint8_t line = ( i == 5 || c < 0x20 || c > 0x7E ) ? 0 : font[c - 0x20][i];
+        for( int8_t j = 0; j < 8; j++, line >>= 1 ){
+            if( line & 0x1 ){
+                if( size == 1 ){
+                    drawPixel(x + i, y + j, color);
+                }
+                else {
+                    fillRect(x + i * size, y + j * size, size, size, color);
+                }
+            }
+            else if( bg != color ){
+                if( size == 1 ){
+                    drawPixel(x + i, y + j, bg);
+                }
+                else {
+                    fillRect(x + i * size, y + j * size, size, size, bg);
+                }
+            }
+        }
+    }
+}
+
+size_t Elegoo_GFX::write ( uint8_t c ) {
+    if( c == '\n' ){
+        cursor_y += textsize * 8;
+        cursor_x = 0;
+    }
+    else if( c != '\r' ){
+        drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+        cursor_x += textsize * 6;
+        if( wrap && cursor_x > _width - textsize * 6 ){
+            cursor_y += textsize * 8;
+            cursor_x = 0;
+        }
+    }
+    return 1;
+}
+
+void Elegoo_GFX::setCursor ( int16_t x, int16_t y )          { cursor_x = x; cursor_y = y; }
+void Elegoo_GFX::setTextColor ( uint16_t c )                 { textcolor = textbgcolor = c; }
+void Elegoo_GFX::setTextColor ( uint16_t c, uint16_t bg )    { textcolor = c; textbgcolor = bg; }
+void Elegoo_GFX::setTextSize ( uint8_t s )                   { textsize = ( s > 0 ) ? s : 1; }
+void Elegoo_GFX::setTextWrap ( bool w )                      { wrap = w; }
+int16_t Elegoo_GFX::width ( void ) const                     { return _width; }
+int16_t Elegoo_GFX::height ( void ) const                    { return _height; }
+uint8_t Elegoo_GFX::getRotation ( void ) const               { return rotation; }
+
+void Elegoo_GFX::setRotation ( uint8_t r ) {
+    rotation = r & 3;
+    _width  = ( rotation & 1 ) ? HEIGHT : WIDTH;
+    _height = ( rotation & 1 ) ? WIDTH : HEIGHT;
+}
+
+/* Buttons*/
+Elegoo_GFX_Button::Elegoo_GFX_Button ( void ) {
+    _gfx = NULL;
+    currstate = laststate = false;
+    _label[0] = '\0';
+}
+
+void Elegoo_GFX_Button::initButton ( Elegoo_GFX* gfx, int16_t x, int16_t y, uint8_t w, uint8_t h,
+                                     uint16_t outline, uint16_t fill, uint16_t textcolor, char* label, uint8_t textsize ) {
+    _gfx = gfx;
+    _x = x;
+    _y = y;
+    _w = w;
+    _h = h;
+    _outlinecolor = outline;
+    _fillcolor = fill;
+    _textcolor = textcolor;
+    _textsize = textsize;
+    strncpy(_label, label, 9);
+    _label[9] = '\0';
+}
+
+void Elegoo_GFX_Button::drawButton ( bool inverted ) {
+    uint16_t fill    = inverted ? _textcolor : _fillcolor;
+    uint16_t outline = _outlinecolor;
+    uint16_t text    = inverted ? _fillcolor : _textcolor;
+    int16_t r = ( _w < _h ? _w : _h ) / 4;
+
+    _gfx->fillRoundRect(_x - _w / 2, _y - _h / 2, _w, _h, r, fill);
+    _gfx->drawRoundRect(_x - _w / 2, _y - _h / 2, _w, _h, r, outline);
+    _gfx->setCursor(_x - strlen(_label) * 3 * _textsize, _y - 4 * _textsize);
+    _gfx->setTextColor(text);
+    _gfx->setTextSize(_textsize);
+    _gfx->print(_label);
+}
+
+bool Elegoo_GFX_Button::contains ( int16_t x, int16_t y ) {
+    return x >= _x - _w / 2 && x <= _x + _w / 2 && y >= _y - _h / 2 && y <= _y + _h / 2;
+}
+
+void Elegoo_GFX_Button::press ( bool p )      { laststate = currstate; currstate = p; }
+bool Elegoo_GFX_Button::isPressed ( void )    { return currstate; }
+bool Elegoo_GFX_Button::justPressed ( void )  { return currstate && !laststate; }
+bool Elegoo_GFX_Button::justReleased ( void ) { return !currstate && laststate; }
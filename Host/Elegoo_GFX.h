@@ -0,0 +1,101 @@
+#ifndef HOST_ELEGOO_GFX_H_
+#define HOST_ELEGOO_GFX_H_
+
+/* Host stand-in for the Elegoo_GFX library. Text, rounded rectangles and
+ * buttons are drawn the same way the AVR library draws them, pixel by pixel
+ * through the virtual drawPixel/drawFastHLine/drawFastVLine/fillRect, so a
+ * subclass that counts those calls sees the same traffic the board does.*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "Arduino.h"
+
+class Print {
+ public:
+    virtual ~Print () {}
+    virtual size_t write (uint8_t c) = 0;
+    size_t write (const uint8_t* buffer, size_t size);
+
+    size_t print (const char* text);
+    size_t print (char c);
+    size_t print (int value, int base = DEC);
+    size_t print (unsigned int value, int base = DEC);
+    size_t print (long value, int base = DEC);
+    size_t print (unsigned long value, int base = DEC);
+    size_t print (double value, int digits = 2);
+    size_t println (void);
+    size_t println (const char* text);
+    size_t println (int value, int base = DEC);
+    size_t println (unsigned int value, int base = DEC);
+    size_t println (long value, int base = DEC);
+    size_t println (unsigned long value, int base = DEC);
+    size_t println (double value, int digits = 2);
+};
+
+class Elegoo_GFX : public Print {
+ public:
+    Elegoo_GFX (int16_t w, int16_t h);
+
+    virtual void drawPixel (int16_t x, int16_t y, uint16_t color) = 0;
+    virtual void drawFastVLine (int16_t x, int16_t y, int16_t h, uint16_t color);
+    virtual void drawFastHLine (int16_t x, int16_t y, int16_t w, uint16_t color);
+    virtual void fillRect (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    virtual void fillScreen (uint16_t color);
+
+    void drawLine (int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void drawRect (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawRoundRect (int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+    void fillRoundRect (int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+    void drawChar (int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size);
+
+    void setCursor (int16_t x, int16_t y);
+    void setTextColor (uint16_t c);
+    void setTextColor (uint16_t c, uint16_t bg);
+    void setTextSize (uint8_t s);
+    void setTextWrap (bool w);
+    virtual void setRotation (uint8_t r);
+
+    int16_t width (void) const;
+    int16_t height (void) const;
+    uint8_t getRotation (void) const;
+
+    virtual size_t write (uint8_t c);
+
+ protected:
+    void drawCircleHelper (int16_t x0, int16_t y0, int16_t r, uint8_t corner, uint16_t color);
+    void fillCircleHelper (int16_t x0, int16_t y0, int16_t r, uint8_t corner, int16_t delta, uint16_t color);
+
+    const int16_t WIDTH, HEIGHT;                    // Unrotated size
+    int16_t _width, _height;
+    int16_t cursor_x, cursor_y;
+    uint16_t textcolor, textbgcolor;
+    uint8_t textsize;
+    uint8_t rotation;
+    bool wrap;
+};
+
+class Elegoo_GFX_Button {
+ public:
+    Elegoo_GFX_Button (void);
+    void initButton (Elegoo_GFX* gfx, int16_t x, int16_t y, uint8_t w, uint8_t h,
+                     uint16_t outline, uint16_t fill, uint16_t textcolor, char* label, uint8_t textsize);
+    void drawButton (bool inverted = false);
+    bool contains (int16_t x, int16_t y);
+
+    void press (bool p);
+    bool isPressed (void);
+    bool justPressed (void);
+    bool justReleased (void);
+
+ private:
+    Elegoo_GFX* _gfx;
+    int16_t _x, _y;
+    uint16_t _w, _h;
+    uint8_t _textsize;
+    uint16_t _outlinecolor, _fillcolor, _textcolor;
+    char _label[10];
+    bool currstate, laststate;
+};
+
+#endif    // HOST_ELEGOO_GFX_H_
@@ -0,0 +1,310 @@
+#include <string.h>
+#include "Elegoo_TFTLCD.h"
+#include "pin_magic.h"
+#include "registers.h"
+
+/* Panel the pin_magic.h bus macros talk to, the last one begun*/
+static Elegoo_TFTLCD* busPanel = NULL;
+
+Elegoo_TFTLCD::Elegoo_TFTLCD ( uint8_t cs, uint8_t cd, uint8_t wr, uint8_t rd, uint8_t rst )
+    : Elegoo_GFX(TFT_WIDTH, TFT_HEIGHT) {
+    (void) cs; (void) cd; (void) wr; (void) rd; (void) rst;
+    memset(gram, 0, sizeof(gram));
+    reset();
+    resetStats();
+}
+
+void Elegoo_TFTLCD::begin ( uint16_t id ) {
+    (void) id;
+    busPanel = this;
+    reset();
+}
+
+void Elegoo_TFTLCD::reset ( void ) {
+    windowX[0] = 0; windowX[1] = TFT_WIDTH - 1;
+    windowY[0] = 0; windowY[1] = TFT_HEIGHT - 1;
+    writeX = writeY = 0;
+    scrollTop = 0;
+    scrollArea = TFT_HEIGHT;
+    scrollStart = 0;
+    busData = true;
+    busCommandByte = 0;
+    busParamCount = 0;
+}
+
+uint16_t Elegoo_TFTLCD::readID ( void ) {
+    return 0x9341;
+}
+
+void Elegoo_TFTLCD::setRotation ( uint8_t r ) {
+    Elegoo_GFX::setRotation(r);
+    stats.calls++;
+    busCommand(ILI9341_MADCTL);                             // MADCTL, one parameter
+    stats.busWrites++;
+}
+
+void Elegoo_TFTLCD::resetStats ( void ) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+/* Screen to panel coordinates, the MADCTL mirroring setRotation() selects*/
+void Elegoo_TFTLCD::toPanel ( int16_t x, int16_t y, int16_t* column, int16_t* row ) {
+    switch( rotation ){
+        case 1:  *column = TFT_WIDTH - 1 - y; *row = x;                      break;
+        case 2:  *column = TFT_WIDTH - 1 - x; *row = TFT_HEIGHT - 1 - y;     break;
+        case 3:  *column = y;                 *row = TFT_HEIGHT - 1 - x;     break;
+        default: *column = x;                 *row = y;                      break;
+    }
+}
+
+void Elegoo_TFTLCD::busCommand ( uint8_t value ) {
+    (void) value;
+    stats.busWrites++;
+}
+
+void Elegoo_TFTLCD::writeRegister32 ( uint8_t reg, uint32_t value ) {
+    (void) value;
+    busCommand(reg);
+    stats.busWrites += 4;
+}
+
+void Elegoo_TFTLCD::setAddrWindow ( int x1, int y1, int x2, int y2 ) {
+    windowX[0] = x1; windowX[1] = x2;
+    windowY[0] = y1; windowY[1] = y2;
+    writeX = x1;
+    writeY = y1;
+
+    stats.addressWindows++;
+    writeRegister32(ILI9341_COLADDRSET, ( (uint32_t) x1 << 16 ) | x2);
+    writeRegister32(ILI9341_PAGEADDRSET, ( (uint32_t) y1 << 16 ) | y2);
+}
+
+/* Column and page end back to the full screen, as the library does after every fill*/
+void Elegoo_TFTLCD::setLR ( void ) {
+    stats.busWrites += 8;
+}
+
+/* Pixels written after RAMWR fill the address window row by row. The
+ * window is kept in screen coordinates; MADCTL mirrors it onto the panel.*/
+void Elegoo_TFTLCD::storeWindow ( uint16_t color, uint32_t length ) {
+    int16_t column, row;
+
+    while( length-- > 0 && writeY <= windowY[1] ){
+        toPanel(writeX, writeY, &column, &row);
+        if( column >= 0 && column < TFT_WIDTH && row >= 0 && row < TFT_HEIGHT ){
+            gram[row][column] = color;
+        }
+        if( ++writeX > windowX[1] ){
+            writeX = windowX[0];
+            writeY++;
+        }
+    }
+}
+
+void Elegoo_TFTLCD::flood ( uint16_t color, uint32_t length ) {
+    uint8_t hi = color >> 8, lo = color & 0xFF;
+
+    busCommand(ILI9341_MEMORYWRITE);
+    stats.busWrites += 2;                                   // First pixel always goes out in full
+    if( length > 1 ){
+        if( hi == lo ){
+            stats.busStrobes += 2 * ( length - 1 );         // Bus already holds the byte, strobe WR only
+        }
+        else {
+            stats.busWrites += 2 * ( length - 1 );
+        }
+    }
+    storeWindow(color, length);
+}
+
+void Elegoo_TFTLCD::drawPixel ( int16_t x, int16_t y, uint16_t color ) {
+    stats.calls++;
+    if( x < 0 || y < 0 || x >= _width || y >= _height ){
+        return;
+    }
+    setAddrWindow(x, y, _width - 1, _height - 1);
+    busCommand(ILI9341_MEMORYWRITE);
+    stats.busWrites += 2;
+    stats.pixelWrites++;
+    storeWindow(color, 1);
+}
+
+void Elegoo_TFTLCD::drawFastHLine ( int16_t x, int16_t y, int16_t length, uint16_t color ) {
+    int16_t x2;
+
+    stats.calls++;
+    if( length <= 0 || y < 0 || y >= _height || x >= _width || ( x2 = x + length - 1 ) < 0 ){
+        return;
+    }
+    if( x < 0 ){
+        length += x;
+        x = 0;
+    }
+    if( x2 >= _width ){
+        x2 = _width - 1;
+        length = x2 - x + 1;
+    }
+    setAddrWindow(x, y, x2, y);
+    flood(color, length);
+    setLR();
+    stats.fills++;
+    stats.filledPixels += length;
+}
+
+void Elegoo_TFTLCD::drawFastVLine ( int16_t x, int16_t y, int16_t length, uint16_t color ) {
+    int16_t y2;
+
+    stats.calls++;
+    if( length <= 0 || x < 0 || x >= _width || y >= _height || ( y2 = y + length - 1 ) < 0 ){
+        return;
+    }
+    if( y < 0 ){
+        length += y;
+        y = 0;
+    }
+    if( y2 >= _height ){
+        y2 = _height - 1;
+        length = y2 - y + 1;
+    }
+    setAddrWindow(x, y, x, y2);
+    flood(color, length);
+    setLR();
+    stats.fills++;
+    stats.filledPixels += length;
+}
+
+void Elegoo_TFTLCD::fillRect ( int16_t x1, int16_t y1, int16_t w, int16_t h, uint16_t color ) {
+    int16_t x2, y2;
+
+    stats.calls++;
+    if( w <= 0 || h <= 0 || x1 >= _width || y1 >= _height ||
+        ( x2 = x1 + w - 1 ) < 0 || ( y2 = y1 + h - 1 ) < 0 ){
+        return;
+    }
+    if( x1 < 0 ){
+        w += x1;
+        x1 = 0;
+    }
+    if( y1 < 0 ){
+        h += y1;
+        y1 = 0;
+    }
+    if( x2 >= _width ){
+        x2 = _width - 1;
+        w = x2 - x1 + 1;
+    }
+    if( y2 >= _height ){
+        y2 = _height - 1;
+        h = y2 - y1 + 1;
+    }
+    setAddrWindow(x1, y1, x2, y2);
+    flood(color, (uint32_t) w * h);
+    setLR();
+    stats.fills++;
+    stats.filledPixels += (uint32_t) w * h;
+}
+
+void Elegoo_TFTLCD::fillScreen ( uint16_t color ) {
+    stats.calls++;
+    setAddrWindow(0, 0, _width - 1, _height - 1);
+    flood(color, (uint32_t) TFT_WIDTH * TFT_HEIGHT);
+    stats.fills++;
+    stats.filledPixels += (uint32_t) TFT_WIDTH * TFT_HEIGHT;
+}
+
+void Elegoo_TFTLCD::setRegisters8 ( uint8_t* ptr, uint8_t n ) {
+    (void) ptr;
+    stats.calls++;
+    stats.busWrites += n;
+}
+
+void Elegoo_TFTLCD::setRegisters16 ( uint16_t* ptr, uint8_t n ) {
+    (void) ptr;
+    stats.calls++;
+    stats.busWrites += 2 * n;
+}
+
+/* Raw bus. Only the scroll commands change what the image shows.*/
+void Elegoo_TFTLCD::busSelect ( bool active ) {
+    if( active ){
+        stats.calls++;
+    }
+    busData = true;
+}
+
+void Elegoo_TFTLCD::busCommandData ( bool data ) {
+    busData = data;
+}
+
+void Elegoo_TFTLCD::busWrite ( uint8_t value ) {
+    stats.busWrites++;
+    if( !busData ){
+        busCommandByte = value;
+        busParamCount = 0;
+        return;
+    }
+    if( busParamCount < sizeof(busParam) ){
+        busParam[busParamCount++] = value;
+    }
+    if( busCommandByte == ILI9341_VERTSCROLLDEF && busParamCount == 6 ){
+        scrollTop  = ( busParam[0] << 8 ) | busParam[1];
+        scrollArea = ( busParam[2] << 8 ) | busParam[3];
+    }
+    else if( busCommandByte == ILI9341_VERTSCROLLSTART && busParamCount == 2 ){
+        scrollStart = ( busParam[0] << 8 ) | busParam[1];
+    }
+}
+
+/* Panel line L inside the scroll area shows GRAM row
+ * scrollTop + ( scrollStart - scrollTop + L - scrollTop ) mod scrollArea*/
+uint16_t Elegoo_TFTLCD::pixel ( int16_t x, int16_t y ) {
+    int16_t column, line;
+
+    toPanel(x, y, &column, &line);
+    if( column < 0 || column >= TFT_WIDTH || line < 0 || line >= TFT_HEIGHT ){
+        return 0;
+    }
+    if( scrollArea > 0 && line >= scrollTop && line < scrollTop + scrollArea &&
+        scrollStart >= scrollTop && scrollStart < scrollTop + scrollArea ){
+        line = scrollTop + ( scrollStart - scrollTop + line - scrollTop ) % scrollArea;
+    }
+    return gram[line][column];
+}
+
+bool Elegoo_TFTLCD::writePPM ( const char* path ) {
+    FILE* file = fopen(path, "wb");
+
+    if( file == NULL ){
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", _width, _height);
+    for( int16_t y = 0; y < _height; y++ ){
+        for( int16_t x = 0; x < _width; x++ ){
+            uint16_t color = pixel(x, y);
+            uint8_t rgb[3] = { (uint8_t) ( ( color >> 11 ) * 255 / 31 ),
+                               (uint8_t) ( ( ( color >> 5 ) & 0x3F ) * 255 / 63 ),
+                               (uint8_t) ( ( color & 0x1F ) * 255 / 31 ) };
+            fwrite(rgb, 1, 3, file);
+        }
+    }
+    return fclose(file) == 0;
+}
+
+/* pin_magic.h stand-in entry points*/
+void hostLcdSelect ( bool active ) {
+    if( busPanel != NULL ){
+        busPanel->busSelect(active);
+    }
+}
+
+void hostLcdCommandData ( bool data ) {
+    if( busPanel != NULL ){
+        busPanel->busCommandData(data);
+    }
+}
+
+void hostLcdWrite8 ( uint8_t value ) {
+    if( busPanel != NULL ){
+        busPanel->busWrite(value);
+    }
+}
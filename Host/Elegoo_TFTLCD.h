@@ -0,0 +1,93 @@
+#ifndef HOST_ELEGOO_TFTLCD_H_
+#define HOST_ELEGOO_TFTLCD_H_
+
+/* Host stand-in for the Elegoo_TFTLCD library, modelled on an ILI9341. Every
+ * drawing call goes through the same bus sequence the AVR library sends to
+ * the shield, which is counted in lcdBusStats, and lands in a 240x320 GRAM
+ * copy that can be written out as an image. The vertical scroll commands
+ * that Display.cpp sends through pin_magic.h are decoded as well, so the
+ * image is what the panel would show, not just what is in its memory.*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include "Arduino.h"
+#include "Elegoo_GFX.h"
+
+#define TFT_WIDTH               240
+#define TFT_HEIGHT              320
+
+/* AVR clock cycles for one byte on the 8-bit shield bus on a Mega, where the
+ * data lines are spread over four ports, and for a bare WR strobe when the
+ * data lines already hold the right byte (flood() with high byte == low byte).
+ * The call overhead covers argument passing, clipping and the virtual call.*/
+#define TFT_CYCLES_PER_WRITE    20
+#define TFT_CYCLES_PER_STROBE   4
+#define TFT_CYCLES_PER_CALL     60
+#define TFT_CPU_MHZ             16
+
+typedef struct lcdBusStatsData {        // Everything sent to the panel since the last reset
+    unsigned long calls;                // drawPixel, drawFastH/VLine, fillRect and bus command sequences
+    unsigned long addressWindows;       // Column/page address set-ups
+    unsigned long pixelWrites;          // Single pixels written with drawPixel
+    unsigned long fills;                // Rectangles and lines sent with one address window and a flood
+    unsigned long filledPixels;         // Pixels covered by those fills
+    unsigned long busWrites;            // Command and data bytes put on the bus
+    unsigned long busStrobes;           // WR strobes that repeat the byte already on the bus
+} lcdBusStats;
+
+static inline unsigned long lcdBusCycles ( const lcdBusStats* stats ) {    // Estimated AVR cycles the traffic costs
+    return stats->calls * TFT_CYCLES_PER_CALL +
+           stats->busWrites * TFT_CYCLES_PER_WRITE +
+           stats->busStrobes * TFT_CYCLES_PER_STROBE;
+}
+
+
+class Elegoo_TFTLCD : public Elegoo_GFX {
+ public:
+    Elegoo_TFTLCD (uint8_t cs, uint8_t cd, uint8_t wr, uint8_t rd, uint8_t rst);
+
+    void begin (uint16_t id = 0x9341);
+    void reset (void);
+    uint16_t readID (void);
+    void setRotation (uint8_t r);
+
+    void drawPixel (int16_t x, int16_t y, uint16_t color);
+    void drawFastHLine (int16_t x, int16_t y, int16_t length, uint16_t color);
+    void drawFastVLine (int16_t x, int16_t y, int16_t length, uint16_t color);
+    void fillRect (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillScreen (uint16_t color);
+    void setAddrWindow (int x1, int y1, int x2, int y2);
+    void setRegisters8 (uint8_t* ptr, uint8_t n);
+    void setRegisters16 (uint16_t* ptr, uint8_t n);
+
+    /* Host only*/
+    lcdBusStats stats;
+    void resetStats (void);
+    uint16_t pixel (int16_t x, int16_t y);                 // Color the panel shows at screen x, y
+    bool writePPM (const char* path);                      // Visible screen as a binary PPM
+
+    /* Raw bus, fed by the pin_magic.h stand-in*/
+    void busSelect (bool active);
+    void busCommandData (bool data);
+    void busWrite (uint8_t value);
+
+ private:
+    void flood (uint16_t color, uint32_t length);
+    void setLR (void);
+    void writeRegister32 (uint8_t reg, uint32_t value);
+    void toPanel (int16_t x, int16_t y, int16_t* column, int16_t* row);
+    void storeWindow (uint16_t color, uint32_t length);
+    void busCommand (uint8_t value);
+
+    uint16_t gram[TFT_HEIGHT][TFT_WIDTH];                  // Panel memory, row is the panel line
+    int16_t windowX[2], windowY[2];                        // Address window in screen coordinates
+    int16_t writeX, writeY;                                // Next pixel of the window to be written
+
+    uint16_t scrollTop, scrollArea, scrollStart;           // VSCRDEF and VSCRSADD state
+    bool busData;
+    uint8_t busCommandByte;
+    uint8_t busParam[8];
+    uint8_t busParamCount;
+};
+
+#endif    // HOST_ELEGOO_TFTLCD_H_
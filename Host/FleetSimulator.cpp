@@ -0,0 +1,612 @@
+/* Host fleet simulator for the BMS tasks in StarterFile/
+ *
+ * Every virtual pack is a complete, independent instance of the measurement,
+ * state of charge, contactor and alarm tasks, wired up the same way setup()
+ * wires the board, and fed by a pack model through its own sensorSource.
+ * Packs follow one of several drive profiles with their own random events,
+ * so the fleet covers the operating envelope: stop and go, highway, hard
+ * driving, fast charging and parked packs with interlock faults.
+ *
+ * The packs run on a work-stealing thread pool. Each worker owns a deque of
+ * packs, takes work from its back and, once it runs dry, steals from the
+ * front of another worker's deque. The virtual clock is per thread, so a
+ * pack sets it when a worker picks it up.
+ *
+ * Every pack checks the tasks against the model as it runs:
+ *  - missed alarm: a limit was exceeded for ALARM_DEADLINE_MS and the alarm
+ *    was still not active
+ *  - false alarm: an alarm stayed active ALARM_DEADLINE_MS after the value
+ *    came back inside its limits
+ *  - SOC error: coulomb counted state of charge against the model's charge
+ * The run fails if any alarm was missed or false, or the SOC drifted more
+ * than SOC_TOLERANCE. Pre-warnings are not alarms; the report counts how
+ * many trips one came before and how much warning it gave, and how many
+ * pre-warnings no trip followed.
+ *
+ * The report also shows what the adaptive sampling costs and buys: the
+ * average rate of every channel, which is what the sampling load on the
+ * board scales with, and the detection latency, from the model leaving its
+ * limits to the first sample that sees it. Running with "fixed" pins every
+ * channel to its default rate for comparison.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -pthread -IHost -IStarterFile -x c++ Host/FleetSimulator.cpp Host/Arduino.cpp \
+ *       -x c StarterFile/Measurement.c StarterFile/Alarm.c StarterFile/StateOfCharge.c \
+ *       StarterFile/Statistics.c StarterFile/History.c StarterFile/Latency.c StarterFile/Capture.c \
+ *       -x c++ StarterFile/Contactor.cpp StarterFile/Gpio.cpp -o /tmp/FleetSimulator
+ *   /tmp/FleetSimulator [packs, default 1000] [simulated seconds, default 600] [threads, default all cores] [fixed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Arduino.h"
+#include "Measurement.h"
+#include "Alarm.h"
+#include "StateOfCharge.h"
+#include "Contactor.h"
+#include "Latency.h"
+
+#define STEP_US             CURRENT_MIN_PERIOD      // One scheduler pass, the fastest channel rate
+#define TASK_PERIOD_MS      1000UL      // SOC, contactor and alarm run once a second, as in loop()
+#define ALARM_DEADLINE_MS   1100UL      // One alarm period plus the slowest channel's sample period
+#define SOC_TOLERANCE       1.0         // Percent
+
+/* Pack model*/
+#define OCV_EMPTY           270.0       // Open circuit voltage at EMPTY and FULL, linear in between
+#define OCV_FULL            400.0
+#define PACK_RESISTANCE     1.0         // Ohms
+#define HEAT_PER_WATT       0.002       // Degrees per second per watt lost in the pack resistance
+#define COOLING             0.01        // Fraction of the difference to ambient lost per second
+
+/* Drive profiles*/
+#define PROFILE_CITY        0
+#define PROFILE_HIGHWAY     1
+#define PROFILE_SPORT       2
+#define PROFILE_CHARGE      3
+#define PROFILE_PARKED      4
+#define PROFILES            5
+
+#define ALARM_HVIL          0
+#define ALARM_CURRENT       1
+#define ALARM_VOLTAGE       2
+#define ALARM_KINDS         3
+
+static const char* profileNames[PROFILES] = { "city", "highway", "sport", "fast charge", "parked" };
+static const char* alarmNames[ALARM_KINDS] = { "HVIL", "over current", "HV range" };
+
+typedef struct alarmCheckData {         // Model truth against the alarm task for one alarm
+    unsigned long outsideSince;         // ms the value left its limits, 0 while inside
+    unsigned long outsideStamp;         // micros() the value left its limits
+    bool detected;                      // A sample has seen the excursion
+    latencyHistogram detection;         // Excursion start to first sample outside the limits
+    unsigned long insideSince;          // ms the value came back inside
+    bool wasActive;
+    bool missCounted;
+    bool falseCounted;
+    unsigned long excursions;           // Excursions that lasted ALARM_DEADLINE_MS or longer
+    unsigned long trips;                // Alarm went active
+    unsigned long missed;
+    unsigned long falseAlarms;
+    bool wasWarning;
+    unsigned long warnedSince;          // ms the pre-warning went up
+    unsigned long warnings;             // Pre-warnings raised
+    unsigned long warnedTrips;          // Trips straight out of a pre-warning
+    unsigned long leadMs;               // Pre-warning to trip, summed over warnedTrips
+} alarmCheck;
+
+typedef struct virtualPackData {
+    /* Pack model, the truth the sensors read*/
+    byte profile;
+    uint32_t random;
+    double trueSoc;                     // Percent, double so 1 ms steps are not lost in rounding
+    float demand;                       // Current the drive asks for, amps
+    float current;                      // Current that flows, 0 with the contactor open
+    float temperature;
+    float ambient;
+    unsigned long burstUntil;           // ms, end of a hard acceleration or a regen burst
+    float burstCurrent;
+    unsigned long hvilOpenUntil;        // ms, end of an interlock fault
+
+    /* One BMS instance: everything setup() wires up for the board*/
+    bool hVIL;
+    float hvCurrent, hvVoltage, measuredTemperature;
+    channelStats currentStats, voltageStats;
+    trendHistory history;
+    channelTable channels;
+    byte clockTick;
+    byte hVoltInterlock, overCurrent, hVoltOutofRange;
+    unsigned long alarmStamp;
+    float currentTimeToLimit, voltageTimeToLimit;
+    bool alarmAcknowledge;                          // Nobody acknowledges in the simulation
+    float stateOfCharge;
+    bool contactorState, contactorLocal, contactorAck;
+    unsigned long contactorStamp;
+    latencyTrace latency;
+
+    measurementData measure;
+    alarmData alarm;
+    stateOfChargeData charge;
+    contactorData contactor;
+
+    /* Results*/
+    alarmCheck checks[ALARM_KINDS];
+    float maxSocError;
+    float minSoc;
+    float maxTemperature;
+    unsigned long dropped;
+    unsigned long samples[MEASUREMENT_CHANNELS];
+} virtualPack;
+
+static bool fixedRates = false;
+
+/* xorshift32, every pack has its own stream so runs repeat exactly*/
+static float randomUnit ( virtualPack* pack ) {
+    pack->random ^= pack->random << 13;
+    pack->random ^= pack->random >> 17;
+    pack->random ^= pack->random << 5;
+    return ( pack->random & 0xFFFFFF ) / 16777216.0f;
+}
+
+static bool randomEvent ( virtualPack* pack, float perSecond ) {
+    return randomUnit(pack) < perSecond * STEP_US / 1000000.0f;
+}
+
+/* Sensor source of a virtual pack, context is the pack*/
+static bool packHvil ( void* context ) {
+    virtualPack* pack = (virtualPack*) context;
+    return ( millis() < pack->hvilOpenUntil ) ? HVIL_OPEN : HVIL_CLOSED;
+}
+
+static float packCurrent ( void* context ) {
+    return ( (virtualPack*) context )->current;
+}
+
+static float packVoltage ( void* context ) {
+    virtualPack* pack = (virtualPack*) context;
+    return OCV_EMPTY + ( OCV_FULL - OCV_EMPTY ) * pack->trueSoc / FULL - pack->current * PACK_RESISTANCE;
+}
+
+static float packTemperature ( void* context ) {
+    return ( (virtualPack*) context )->temperature;
+}
+
+static const sensorSource packSensors = { packHvil, packCurrent, packVoltage, packTemperature };
+
+/* Current the driver asks for at time ms, amps, positive discharges*/
+static float driveDemand ( virtualPack* pack, unsigned long ms ) {
+    float t = ms / 1000.0f;
+    float noise = ( randomUnit(pack) - 0.5f ) * 1.0f;
+
+    if( ms < pack->burstUntil ){
+        return pack->burstCurrent + noise;
+    }
+    switch( pack->profile ){
+        case PROFILE_CITY: {                                    // 40 s cycle: pull away, cruise, regen, stop
+            float phase = fmodf(t, 40.0f);
+            if( randomEvent(pack, 0.004f) ){                    // Now and then floor it
+                pack->burstUntil = ms + 1000 + (unsigned long) ( randomUnit(pack) * 2500 );
+                pack->burstCurrent = 27.0f + randomUnit(pack) * 5.0f;
+            }
+            return ( phase < 8 ? 18.0f : phase < 20 ? 6.0f : phase < 24 ? -4.0f : 0.0f ) + noise;
+        }
+        case PROFILE_HIGHWAY:
+            if( randomEvent(pack, 0.002f) ){                    // Overtake
+                pack->burstUntil = ms + 2000 + (unsigned long) ( randomUnit(pack) * 3000 );
+                pack->burstCurrent = 23.0f + randomUnit(pack) * 6.0f;
+            }
+            return 14.0f + 4.0f * sinf(t / 30.0f) + noise;
+        case PROFILE_SPORT:
+            if( randomEvent(pack, 0.06f) ){                     // Hard launches and heavy regen
+                pack->burstUntil = ms + 500 + (unsigned long) ( randomUnit(pack) * 3000 );
+                pack->burstCurrent = ( randomUnit(pack) < 0.7f ) ? 20.0f + randomUnit(pack) * 15.0f
+                                                                 : -3.0f - randomUnit(pack) * 6.0f;
+            }
+            return 10.0f + 6.0f * sinf(t / 7.0f) + noise;
+        case PROFILE_CHARGE:
+            if( randomEvent(pack, 0.003f) ){                    // Charger current spike
+                pack->burstUntil = ms + 800 + (unsigned long) ( randomUnit(pack) * 2000 );
+                pack->burstCurrent = -6.0f - randomUnit(pack) * 3.0f;
+            }
+            return -4.5f + noise * 0.2f;
+        default:
+            return 0.2f + noise * 0.1f;
+    }
+}
+
+/* Moves the model forward one step*/
+static void stepModel ( virtualPack* pack, unsigned long ms ) {
+    float seconds = STEP_US / 1000000.0f;
+
+    float interlockFaults = ( pack->profile == PROFILE_PARKED ) ? 0.01f : 0.001f;
+    if( ms >= pack->hvilOpenUntil && randomEvent(pack, interlockFaults) ){
+        pack->hvilOpenUntil = ms + 500 + (unsigned long) ( randomUnit(pack) * 6000 );
+    }
+
+    pack->demand  = driveDemand(pack, ms);
+    pack->current = hostPinLevel[CONTACTOR_PIN] ? pack->demand : 0.0f;
+
+    pack->trueSoc -= pack->current * seconds / ( pack->charge.capacity * 36.0 );
+    if( pack->trueSoc < EMPTY ){
+        pack->trueSoc = EMPTY;
+    }
+    else if( pack->trueSoc > FULL ){
+        pack->trueSoc = FULL;
+    }
+
+    pack->temperature += ( pack->current * pack->current * PACK_RESISTANCE * HEAT_PER_WATT -
+                           ( pack->temperature - pack->ambient ) * COOLING ) * seconds;
+}
+
+/* Whether each alarm's value is outside its limits, from the model*/
+static void modelOutside ( virtualPack* pack, bool outside[ALARM_KINDS] ) {
+    float voltage = packVoltage(pack);
+    outside[ALARM_HVIL]    = packHvil(pack) == HVIL_OPEN;
+    outside[ALARM_CURRENT] = pack->current < CURRENT_MIN || pack->current > CURRENT_MAX;
+    outside[ALARM_VOLTAGE] = voltage < VOLTAGE_MIN || voltage > VOLTAGE_MAX;
+}
+
+/* Follows the model's excursions every step*/
+static void trackExcursions ( virtualPack* pack, unsigned long ms ) {
+    bool outside[ALARM_KINDS];
+    modelOutside(pack, outside);
+
+    for( byte k = 0; k < ALARM_KINDS; k++ ){
+        alarmCheck* check = &pack->checks[k];
+        if( outside[k] && check->outsideSince == 0 ){
+            check->outsideSince = ms;
+            check->outsideStamp = micros();
+            check->detected = false;
+            check->missCounted = false;
+        }
+        else if( !outside[k] && check->outsideSince != 0 ){
+            if( ms - check->outsideSince >= ALARM_DEADLINE_MS ){
+                check->excursions++;
+            }
+            check->outsideSince = 0;
+            check->insideSince = ms;
+            check->falseCounted = false;
+        }
+    }
+}
+
+/* Detection latency: the first sample to see each excursion*/
+static void trackDetection ( virtualPack* pack ) {
+    bool seen[ALARM_KINDS] = { pack->hVIL == HVIL_OPEN,
+                               pack->hvCurrent < CURRENT_MIN || pack->hvCurrent > CURRENT_MAX,
+                               pack->hvVoltage < VOLTAGE_MIN || pack->hvVoltage > VOLTAGE_MAX };
+
+    for( byte k = 0; k < ALARM_KINDS; k++ ){
+        alarmCheck* check = &pack->checks[k];
+        if( check->outsideSince != 0 && !check->detected && seen[k] ){
+            recordLatency(&check->detection, check->outsideStamp, micros());
+            check->detected = true;
+        }
+    }
+}
+
+/* Compares the alarm task with the model after every alarm evaluation*/
+static void checkAlarms ( virtualPack* pack, unsigned long ms ) {
+    byte states[ALARM_KINDS] = { pack->hVoltInterlock, pack->overCurrent, pack->hVoltOutofRange };
+
+    for( byte k = 0; k < ALARM_KINDS; k++ ){
+        alarmCheck* check = &pack->checks[k];
+        bool active = states[k] == ACTIVE_NO_ACK || states[k] == ACTIVE_ACK;
+        bool warning = states[k] == PRE_WARNING;
+
+        if( warning && !check->wasWarning ){
+            check->warnings++;
+            check->warnedSince = ms;
+        }
+        if( active && !check->wasActive ){
+            check->trips++;
+            if( check->wasWarning ){
+                check->warnedTrips++;
+                check->leadMs += ms - check->warnedSince;
+            }
+        }
+        check->wasActive = active;
+        check->wasWarning = warning;
+
+        if( !active && check->outsideSince != 0 && !check->missCounted &&
+            ms - check->outsideSince >= ALARM_DEADLINE_MS ){
+            check->missed++;
+            check->missCounted = true;
+        }
+        if( active && check->outsideSince == 0 && !check->falseCounted &&
+            ms - check->insideSince >= ALARM_DEADLINE_MS ){
+            check->falseAlarms++;
+            check->falseCounted = true;
+        }
+    }
+}
+
+/* Fleet supervisor: opens the contactor while the interlock alarm is
+ * active and closes it again once it clears, like a driver would with the
+ * battery screen buttons*/
+static void supervise ( virtualPack* pack ) {
+    bool wanted = pack->hVoltInterlock == NOT_ACTIVE;
+
+    if( wanted != pack->contactorState ){
+        pack->contactorState = wanted;
+        pack->contactorStamp = micros();
+    }
+}
+
+/* Wires one BMS instance the way setup() does, on the calling thread's clock*/
+static void startPack ( virtualPack* pack ) {
+    hostSetMicros(0);
+    hostPinLevel[CONTACTOR_PIN] = LOW;
+
+    pack->trueSoc        = ( pack->profile == PROFILE_CHARGE ) ? 80.0f + randomUnit(pack) * 20.0f
+                                                               : 15.0f + randomUnit(pack) * 85.0f;
+    pack->ambient        = randomUnit(pack) * 40.0f;
+    pack->temperature    = pack->ambient;
+    pack->stateOfCharge  = pack->trueSoc;               // Starts from a known charge, as after a full charge
+    pack->contactorState = true;
+    pack->contactorLocal = false;
+    pack->minSoc         = pack->trueSoc;
+
+    initChannelStats(&pack->currentStats, millis());
+    initChannelStats(&pack->voltageStats, millis());
+    initMeasurementChannels(&pack->channels, micros());
+    if( fixedRates ){
+        for( byte i = 0; i < MEASUREMENT_CHANNELS; i++ ){
+            channelConfig config = pack->channels.channel[i].config;
+            config.minPeriod = config.maxPeriod = config.period;
+            setChannelConfig(&pack->channels, i, config);
+        }
+    }
+    pack->measure = { &pack->hVIL, &pack->measuredTemperature, &pack->hvCurrent, &pack->hvVoltage,
+                      &pack->currentStats, &pack->voltageStats, &pack->history, &pack->channels,
+                      &pack->clockTick, &packSensors, pack, NULL };
+    pack->alarm = { &pack->hVoltInterlock, &pack->overCurrent, &pack->hVoltOutofRange,
+                    &pack->hVIL, &pack->hvCurrent, &pack->hvVoltage,
+                    &pack->channels, &pack->alarmStamp, &pack->latency,
+                    &pack->currentStats, &pack->voltageStats,
+                    &pack->currentTimeToLimit, &pack->voltageTimeToLimit, &pack->alarmAcknowledge };
+    pack->charge = { &pack->stateOfCharge, &pack->currentStats, PACK_CAPACITY, micros() };
+    pack->contactor = { &pack->contactorState, &pack->contactorLocal, &pack->contactorAck,
+                        &pack->contactorStamp, &pack->latency };
+}
+
+/* Runs one pack for the whole simulated time*/
+static void runPack ( virtualPack* pack, unsigned long seconds ) {
+
+    startPack(pack);
+
+    for( unsigned long long us = 0; us < seconds * 1000000ULL; us += STEP_US ){
+        unsigned long ms = us / 1000;
+
+        stepModel(pack, ms);
+        trackExcursions(pack, ms);
+        measurementTask(&pack->measure);
+        trackDetection(pack);
+
+        if( us > 0 && us % ( TASK_PERIOD_MS * 1000 ) == 0 ){   // Same order as loop()
+            pack->clockTick = ( pack->clockTick + 1 ) % 18;
+            stateOfChargeTask(&pack->charge);
+            supervise(pack);
+            contactorTask(&pack->contactor);
+            alarmTask(&pack->alarm);
+            checkAlarms(pack, ms);
+
+            float error = fabsf(pack->stateOfCharge - pack->trueSoc);
+            if( error > pack->maxSocError ){
+                pack->maxSocError = error;
+            }
+            if( pack->trueSoc < pack->minSoc ){
+                pack->minSoc = pack->trueSoc;
+            }
+        }
+        if( pack->temperature > pack->maxTemperature ){
+            pack->maxTemperature = pack->temperature;
+        }
+        hostAdvanceMicros(STEP_US);
+    }
+    for( byte i = 0; i < MEASUREMENT_CHANNELS; i++ ){
+        pack->dropped += pack->channels.channel[i].dropped;
+        pack->samples[i] = pack->channels.channel[i].samples;
+    }
+}
+
+/* Work-stealing pool*/
+typedef struct workerQueueData {
+    std::mutex lock;
+    std::deque<virtualPack*> packs;
+} workerQueue;
+
+static std::vector<workerQueue*> queues;
+static std::atomic<unsigned long> steals(0);
+
+static virtualPack* takeWork ( unsigned int self ) {
+    virtualPack* pack = NULL;
+    {
+        std::lock_guard<std::mutex> hold(queues[self]->lock);
+        if( !queues[self]->packs.empty() ){
+            pack = queues[self]->packs.back();
+            queues[self]->packs.pop_back();
+            return pack;
+        }
+    }
+    for( unsigned int i = 1; i < queues.size(); i++ ){          // Own deque is empty, steal the oldest work of another
+        workerQueue* victim = queues[( self + i ) % queues.size()];
+        std::lock_guard<std::mutex> hold(victim->lock);
+        if( !victim->packs.empty() ){
+            pack = victim->packs.front();
+            victim->packs.pop_front();
+            steals++;
+            return pack;
+        }
+    }
+    return NULL;                                                // Packs never create work, so empty everywhere means done
+}
+
+static void worker ( unsigned int self, unsigned long seconds ) {
+    virtualPack* pack;
+    while( ( pack = takeWork(self) ) != NULL ){
+        runPack(pack, seconds);
+    }
+}
+
+static void mergeHistogram ( latencyHistogram* into, const latencyHistogram* from ) {
+    for( byte b = 0; b < LATENCY_BUCKETS; b++ ){
+        into->count[b] += from->count[b];
+    }
+    into->samples += from->samples;
+    if( from->maximum > into->maximum ){
+        into->maximum = from->maximum;
+    }
+}
+
+int main ( int argc, char** argv ) {
+    unsigned long packCount = ( argc > 1 ) ? strtoul(argv[1], NULL, 10) : 1000;
+    unsigned long seconds   = ( argc > 2 ) ? strtoul(argv[2], NULL, 10) : 600;
+    unsigned int threads    = ( argc > 3 ) ? strtoul(argv[3], NULL, 10) : std::thread::hardware_concurrency();
+    std::vector<virtualPack> packs(packCount);
+    std::vector<std::thread> pool;
+    int failures = 0;
+
+    if( threads == 0 ){
+        threads = 1;
+    }
+    fixedRates = argc > 4 && strcmp(argv[4], "fixed") == 0;
+    for( unsigned long i = 0; i < packCount; i++ ){
+        memset(&packs[i], 0, sizeof(virtualPack));
+        packs[i].profile = i % PROFILES;
+        packs[i].random  = 2463534242UL + i * 2654435761UL;
+    }
+    for( unsigned int t = 0; t < threads; t++ ){                  // Deal packs out in blocks, stealing evens the load
+        queues.push_back(new workerQueue);
+    }
+    for( unsigned long i = 0; i < packCount; i++ ){
+        queues[i * threads / packCount]->packs.push_back(&packs[i]);
+    }
+
+    printf("%lu packs, %lu simulated seconds each, %u threads, %s sampling rates\n", packCount, seconds, threads,
+           fixedRates ? "fixed" : "adaptive");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( unsigned int t = 0; t < threads; t++ ){
+        pool.push_back(std::thread(worker, t, seconds));
+    }
+    for( unsigned int t = 0; t < threads; t++ ){
+        pool[t].join();
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%.2f s wall, %.0f pack-seconds per second, %lu steals\n\n",
+           wall, packCount * (double) seconds / wall, steals.load());
+
+    printf("%-12s %5s  %-12s %10s %7s %7s %7s %9s %7s %9s\n", "profile", "packs", "alarm", "excursions", "trips",
+           "missed", "false", "warnings", "warned", "lead s");
+    for( byte p = 0; p < PROFILES; p++ ){
+        for( byte k = 0; k < ALARM_KINDS; k++ ){
+            alarmCheck total;
+            unsigned long count = 0;
+            memset(&total, 0, sizeof(total));
+            for( unsigned long i = 0; i < packCount; i++ ){
+                if( packs[i].profile != p ){
+                    continue;
+                }
+                total.excursions  += packs[i].checks[k].excursions;
+                total.trips       += packs[i].checks[k].trips;
+                total.missed      += packs[i].checks[k].missed;
+                total.falseAlarms += packs[i].checks[k].falseAlarms;
+                total.warnings    += packs[i].checks[k].warnings;
+                total.warnedTrips += packs[i].checks[k].warnedTrips;
+                total.leadMs      += packs[i].checks[k].leadMs;
+                count++;
+            }
+            if( k == 0 ){
+                printf("%-12s %5lu  ", profileNames[p], count);
+            }
+            else {
+                printf("%-12s %5s  ", "", "");
+            }
+            printf("%-12s %10lu %7lu %7lu %7lu %9lu %7lu %9.1f\n", alarmNames[k], total.excursions, total.trips,
+                   total.missed, total.falseAlarms, total.warnings, total.warnedTrips,
+                   total.warnedTrips ? total.leadMs / 1000.0 / total.warnedTrips : 0.0);
+            failures += ( total.missed + total.falseAlarms ) > 0;
+        }
+    }
+
+    printf("\n%-12s %14s %10s %10s %10s\n", "profile", "max SOC error", "min SOC", "max temp", "dropped");
+    for( byte p = 0; p < PROFILES; p++ ){
+        float socError = 0, minSoc = FULL, maxTemperature = -100;
+        unsigned long dropped = 0;
+        for( unsigned long i = 0; i < packCount; i++ ){
+            if( packs[i].profile != p ){
+                continue;
+            }
+            socError       = fmaxf(socError, packs[i].maxSocError);
+            minSoc         = fminf(minSoc, packs[i].minSoc);
+            maxTemperature = fmaxf(maxTemperature, packs[i].maxTemperature);
+            dropped       += packs[i].dropped;
+        }
+        printf("%-12s %13.3f%% %9.1f%% %9.1fC %10lu\n", profileNames[p], socError, minSoc, maxTemperature, dropped);
+        failures += socError > SOC_TOLERANCE;
+    }
+
+    static const char* channelNames[MEASUREMENT_CHANNELS] = { "HVIL", "current", "voltage", "temp", "history" };
+    printf("\n%-12s", "samples/s");
+    for( byte c = 0; c < MEASUREMENT_CHANNELS; c++ ){
+        printf(" %9s", channelNames[c]);
+    }
+    printf(" %9s\n", "total");
+    for( byte p = 0; p < PROFILES; p++ ){
+        double rates[MEASUREMENT_CHANNELS] = { 0 };
+        double total = 0;
+        unsigned long count = 0;
+        for( unsigned long i = 0; i < packCount; i++ ){
+            if( packs[i].profile != p ){
+                continue;
+            }
+            for( byte c = 0; c < MEASUREMENT_CHANNELS; c++ ){
+                rates[c] += packs[i].samples[c] / (double) seconds;
+            }
+            count++;
+        }
+        printf("%-12s", profileNames[p]);
+        for( byte c = 0; c < MEASUREMENT_CHANNELS; c++ ){
+            printf(" %9.1f", count ? rates[c] / count : 0.0);
+            total += count ? rates[c] / count : 0.0;
+        }
+        printf(" %9.1f\n", total);
+    }
+
+    printf("\n%-12s %10s %10s %10s %10s\n", "detection", "excursions", "p50 us", "p99 us", "max us");
+    for( byte k = 0; k < ALARM_KINDS; k++ ){
+        latencyHistogram detection;
+        memset(&detection, 0, sizeof(detection));
+        for( unsigned long i = 0; i < packCount; i++ ){
+            mergeHistogram(&detection, &packs[i].checks[k].detection);
+        }
+        printf("%-12s %10lu %10lu %10lu %10lu\n", alarmNames[k], detection.samples,
+               latencyPercentile(&detection, 50), latencyPercentile(&detection, 99), detection.maximum);
+    }
+
+    latencyHistogram toAlarm, toPin;
+    memset(&toAlarm, 0, sizeof(toAlarm));
+    memset(&toPin, 0, sizeof(toPin));
+    for( unsigned long i = 0; i < packCount; i++ ){
+        mergeHistogram(&toAlarm, &packs[i].latency.sampleToAlarm);
+        mergeHistogram(&toPin, &packs[i].latency.commandToPin);
+    }
+    printf("\nsample-to-alarm p50 <= %lu us, p99 <= %lu us, max %lu us\n",
+           latencyPercentile(&toAlarm, 50), latencyPercentile(&toAlarm, 99), toAlarm.maximum);
+    printf("command-to-pin  p50 <= %lu us, p99 <= %lu us, max %lu us\n",
+           latencyPercentile(&toPin, 50), latencyPercentile(&toPin, 99), toPin.maximum);
+
+    for( unsigned int t = 0; t < threads; t++ ){
+        delete queues[t];
+    }
+    if( failures ){
+        printf("\n%d checks failed\n", failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,392 @@
+/* Host benchmark for the pipelined module bus master in StarterFile/ModuleBus.c
+ *
+ * An in-process simulator stands in for Serial1 and a daisy chain of 1 to 32
+ * slave modules. Requests and replies take their real wire time at BUS_BAUD,
+ * each module needs MODULE_PROCESS_US to answer, and replies share one return
+ * line. The table shows how long a full sweep of the pack takes with one
+ * request in flight (stop and wait) and with deeper pipelines.
+ * Sweep time stays linear in the module count: every reply crosses the
+ * one shared return line, so a sweep can never be shorter than the
+ * modules' reply wire time, about 0.87 ms per module at BUS_BAUD. The
+ * pipeline only hides the per request turnaround; the sub-linear pack
+ * refresh the module bus was meant to reach is not met with this
+ * protocol, which would need a broadcast request with shorter replies or
+ * replies aggregated along the chain.
+ * Faults are then injected one at a time, a silent module, a bad CRC, a
+ * reply cut short, noise on the line and a reply that arrives while the
+ * request ahead of it times out, and each case checks which modules went
+ * invalid, that every other module and the merged pack values are right,
+ * and that the faulty module recovers once the fault is gone. Last, the
+ * measurement task of a board reads its pack voltage and temperature
+ * through moduleSensors: the fallback until the first full sweep, then a
+ * module drops out mid-run and the last full sweep's values must be held,
+ * never the fallback's on any pass, with the module fault set until the
+ * module is back.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -c -IHost Host/Arduino.cpp -o /tmp/Arduino.o
+ *   gcc -O2 -IHost -IStarterFile Host/ModuleBusBench.c StarterFile/ModuleBus.c \
+ *       StarterFile/Measurement.c StarterFile/Statistics.c StarterFile/History.c StarterFile/Capture.c \
+ *       -x c++ StarterFile/Gpio.cpp -x none /tmp/Arduino.o -lm -lstdc++ -o /tmp/ModuleBusBench
+ *   /tmp/ModuleBusBench
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "Arduino.h"
+#include "ModuleBus.h"
+#include "Measurement.h"
+
+#define BYTE_US             ( 10000000UL / BUS_BAUD )   // 8N1 frame time
+#define MODULE_PROCESS_US   500UL                       // Request received to reply ready
+#define HOP_US              5UL                         // Forwarding delay per module along the chain
+#define STEP_US             10UL                        // Simulation step between moduleBusTask calls
+#define SWEEPS              20
+#define RX_BUFFER           4096
+
+#define FAULT_MODULES       16                          // Pack the faults are injected into
+#define FAULT_WINDOW        4
+#define NO_MODULE           0xFF
+#define CUT_LENGTH          6                           // Bytes of a cut short reply that get through
+#define LATE_LEAD_US        ( 4 * BYTE_US )             // A late reply is this far in when the request ahead times out
+#define BOARD_MODULES       8                           // Pack of the measurement check, as on the board
+#define PHASE_US            1500000UL                   // Long enough for a temperature sample
+
+/* Simulated wire state*/
+static unsigned long downFree;                          // When the master to chain line is free again
+static unsigned long upFree;                            // When the chain to master line is free again
+static byte request[BUS_REQUEST_LENGTH];
+static byte requestCount;
+
+static byte rxData[RX_BUFFER];                          // Reply bytes and the time each one reaches the master
+static unsigned long rxArrival[RX_BUFFER];
+static unsigned int rxHead, rxTail;
+static unsigned long askedAt[MAX_MODULES];              // When the master wrote each module's last request
+
+/* Injected faults, the module each one hits or NO_MODULE*/
+static byte silentModule = NO_MODULE;                   // Never answers
+static byte corruptModule = NO_MODULE;                  // Answers with a data byte flipped
+static byte cutModule = NO_MODULE;                      // Answer stops after CUT_LENGTH bytes
+static byte noisyModule = NO_MODULE;                    // Noise with a start byte in it comes first
+static byte lateModule = NO_MODULE;                     // The module ahead is silent and this one answers just as
+                                                        //  the request ahead times out
+
+static const byte noise[] = { BUS_SOF_RESPONSE, 0x13, 0x00 };
+
+static void pushByte ( byte value, unsigned long* at ) {
+    *at += BYTE_US;
+    rxData[rxTail % RX_BUFFER]    = value;
+    rxArrival[rxTail % RX_BUFFER] = *at;
+    rxTail++;
+}
+
+/* Readings module address sends*/
+static float moduleVolts ( byte address )   { return ( 4800 + address ) * 0.01; }
+static float moduleMaxCell ( byte address ) { return ( 4010 + address ) * 0.001; }
+static float moduleCelsius ( byte address ) { return ( 50 + address % 10 ) * 0.5; }
+
+static void moduleReply ( byte address, unsigned long requestDone ) {
+    byte reply[BUS_RESPONSE_LENGTH];
+    byte length = BUS_RESPONSE_LENGTH;
+    unsigned int voltage = 4800 + address;              // 48.00 V and up, 10 mV units
+    unsigned int minCell = 3990, maxCell = 4010 + address;
+    unsigned long start = requestDone + MODULE_PROCESS_US + 2 * HOP_US * ( address + 1 );
+
+    if( address == silentModule || ( lateModule != NO_MODULE && address + 1 == lateModule ) ){
+        return;
+    }
+
+    reply[0] = BUS_SOF_RESPONSE;
+    reply[1] = address;
+    reply[2] = voltage & 0xFF; reply[3] = voltage >> 8;
+    reply[4] = minCell & 0xFF; reply[5] = minCell >> 8;
+    reply[6] = maxCell & 0xFF; reply[7] = maxCell >> 8;
+    reply[8] = (byte) ( 50 + address % 10 );            // 25 C and up, 0.5 C units
+    reply[9] = busCrc8(reply, BUS_RESPONSE_LENGTH - 1);
+
+    if( address == corruptModule ){
+        reply[4] ^= 0x10;
+    }
+    if( address == cutModule ){
+        length = CUT_LENGTH;
+    }
+    if( address == lateModule && address > 0 ){
+        start = askedAt[address - 1] + BUS_TIMEOUT - LATE_LEAD_US;
+    }
+    if( start < upFree ){
+        start = upFree;
+    }
+    if( address == noisyModule ){
+        for( byte i = 0; i < sizeof(noise); i++ ){
+            pushByte(noise[i], &start);
+        }
+    }
+    for( byte i = 0; i < length; i++ ){
+        pushByte(reply[i], &start);
+    }
+    upFree = start;
+}
+
+static int simAvailable ( void ) {
+    unsigned int ready = rxHead;
+    while( ready != rxTail && (long) ( micros() - rxArrival[ready % RX_BUFFER] ) >= 0 ){
+        ready++;
+    }
+    return (int) ( ready - rxHead );
+}
+
+static int simRead ( void ) {
+    if( simAvailable() == 0 ){
+        return -1;
+    }
+    return rxData[rxHead++ % RX_BUFFER];
+}
+
+static void simWrite ( const byte* data, byte length ) {
+    unsigned long at = ( micros() > downFree ) ? micros() : downFree;
+
+    for( byte i = 0; i < length; i++ ){
+        at += BYTE_US;
+        request[requestCount++] = data[i];
+        if( requestCount == BUS_REQUEST_LENGTH ){
+            requestCount = 0;
+            if( busCrc8(request, BUS_REQUEST_LENGTH - 1) == request[BUS_REQUEST_LENGTH - 1] ){
+                askedAt[request[1]] = micros();
+                moduleReply(request[1], at);
+            }
+        }
+    }
+    downFree = at;
+}
+
+static moduleBusPort simPort = { simAvailable, simRead, simWrite };
+
+static moduleReading modules[MAX_MODULES];
+static packSummary pack;
+static moduleBus bus;
+
+static void startChain ( byte count, byte window ) {
+    downFree = upFree = micros();
+    rxHead = rxTail = 0;
+    requestCount = 0;
+    memset(&pack, 0, sizeof(pack));
+    initModuleBus(&bus, &simPort, modules, &pack, count, window, micros());
+}
+
+/* Runs the master until sweeps more sweeps have been merged*/
+static void finishSweeps ( unsigned long sweeps ) {
+    unsigned long until = pack.sweeps + sweeps;
+    while( pack.sweeps < until ){
+        moduleBusTask(&bus);
+        hostAdvanceMicros(STEP_US);
+    }
+}
+
+/* Average sweep time in microseconds over SWEEPS sweeps after the first*/
+static unsigned long runSweeps ( byte count, byte window, byte* validModules ) {
+    unsigned long total = 0;
+    unsigned long seen = 0;
+
+    startChain(count, window);
+
+    while( pack.sweeps <= SWEEPS ){
+        moduleBusTask(&bus);
+        if( pack.sweeps != seen ){
+            if( seen > 0 ){                                 // First sweep includes start up
+                total += pack.sweepTime;
+            }
+            seen = pack.sweeps;
+        }
+        hostAdvanceMicros(STEP_US);
+    }
+    *validModules = pack.validModules;
+    return total / ( SWEEPS - 1 );
+}
+
+/* Checks that exactly the module lost is invalid, if any, and that the
+ * merged pack holds every other module's readings. Returns whether it
+ * did and prints what went wrong.*/
+static bool checkPack ( byte lost ) {
+    bool ok = true;
+    float voltage = 0, maxCell = 0, maxTemperature = 0;
+    byte valid = 0;
+
+    for( byte i = 0; i < bus.moduleCount; i++ ){
+        if( modules[i].valid != ( i != lost ) ){
+            printf("    module %u is %s\n", i, modules[i].valid ? "valid" : "invalid");
+            ok = false;
+        }
+        if( i == lost ){
+            continue;
+        }
+        voltage += moduleVolts(i);
+        maxCell = fmax(maxCell, moduleMaxCell(i));
+        maxTemperature = fmax(maxTemperature, moduleCelsius(i));
+        valid++;
+    }
+    if( pack.validModules != valid || fabs(pack.voltage - voltage) > 0.005 || fabs(pack.minCell - 3.990) > 0.0005 ||
+        fabs(pack.maxCell - maxCell) > 0.0005 || pack.maxTemperature != maxTemperature ){
+        printf("    pack %u modules %.2f V cells %.3f - %.3f V %.1f C, expected %u modules %.2f V cells 3.990 - %.3f V %.1f C\n",
+               pack.validModules, pack.voltage, pack.minCell, pack.maxCell, pack.maxTemperature,
+               valid, voltage, maxCell, maxTemperature);
+        ok = false;
+    }
+    return ok;
+}
+
+/* Injects one fault into a 16 module pack, checks the module it hits, and
+ * only that one, goes invalid, then clears it and checks the module is
+ * back. Returns whether both held.*/
+static bool faultCase ( const char* name, byte* fault, byte module, byte lost ) {
+    unsigned long crcErrors, timeouts = 0;
+    bool hit, recovered;
+
+    startChain(FAULT_MODULES, FAULT_WINDOW);
+    finishSweeps(2);
+    crcErrors = bus.crcErrors;
+    for( byte i = 0; i < FAULT_MODULES; i++ ){
+        timeouts += modules[i].timeouts;
+    }
+
+    *fault = module;
+    finishSweeps(2);                                    // The first may have started before the fault
+    hit = checkPack(lost);
+    crcErrors = bus.crcErrors - crcErrors;
+    for( byte i = 0; i < FAULT_MODULES; i++ ){
+        timeouts -= modules[i].timeouts;
+    }
+
+    *fault = NO_MODULE;
+    finishSweeps(2);
+    recovered = checkPack(NO_MODULE);
+
+    printf("%-34s module %2u: %2lu CRC errors, %2lu timeouts, %s, %s\n", name, module, crcErrors, -timeouts,
+           hit ? "right modules lost" : "WRONG MODULES LOST", recovered ? "recovered" : "NOT RECOVERED");
+    return hit && recovered;
+}
+
+/* Fallback readings of the measurement check*/
+static bool fallbackHvil ( void* context )         { (void) context; return HVIL_CLOSED; }
+static float fallbackCurrent ( void* context )     { (void) context; return 10.0; }
+static float fallbackVoltage ( void* context )     { (void) context; return 300.0; }
+static float fallbackTemperature ( void* context ) { (void) context; return 20.0; }
+
+static const sensorSource fallbackSensors = { fallbackHvil, fallbackCurrent, fallbackVoltage, fallbackTemperature };
+
+/* Runs the module chain and measurement task of a board for PHASE_US and
+ * checks the voltage and temperature measured and the module fault at the
+ * end. With labAllowed false no pass may measure the fallback voltage.*/
+static bool measurePhase ( const char* name, measurementData* measure, float voltage, float temperature,
+                           bool fault, bool labAllowed ) {
+    const moduleSensor* sensor = (const moduleSensor*) measure->sensorContext;
+    unsigned long lab = 0;
+    bool ok;
+
+    for( unsigned long us = 0; us < PHASE_US; us += STEP_US ){
+        moduleBusTask(&bus);
+        measurementTask(measure);
+        if( fabs(*measure->hvVoltage - fallbackVoltage(NULL)) < 0.005 ){
+            lab++;
+        }
+        hostAdvanceMicros(STEP_US);
+    }
+    ok = fabs(*measure->hvVoltage - voltage) < 0.005 && fabs(*measure->temperature - temperature) < 0.005 &&
+         sensor->fault == fault && ( labAllowed || lab == 0 );
+    printf("%-34s %7.2f V %5.1f C fault %u, expected %7.2f V %5.1f C fault %u, %6lu passes at the fallback %s\n",
+           name, *measure->hvVoltage, *measure->temperature, sensor->fault, voltage, temperature, fault, lab,
+           ok ? "" : "WRONG");
+    return ok;
+}
+
+/* A board measuring through moduleSensors sees the modules' pack voltage
+ * and hottest module, the fallback only before the first full sweep, and
+ * the last full sweep's values with the fault set while a module is
+ * missing*/
+static bool measureCheck ( void ) {
+    static channelStats currentStats, voltageStats;
+    static trendHistory history;
+    static channelTable channels;
+    static bool hVIL;
+    static float temperature, hvCurrent, hvVoltage;
+    static byte clockTick;
+    static moduleSensor packSensors;
+    static measurementData measure;
+    float voltage = 0, hottest = 0;
+    bool ok = true;
+
+    for( byte i = 0; i < BOARD_MODULES; i++ ){
+        voltage += moduleVolts(i);
+        hottest = fmax(hottest, moduleCelsius(i));
+    }
+
+    startChain(BOARD_MODULES, FAULT_WINDOW);
+    initChannelStats(&currentStats, millis());
+    initChannelStats(&voltageStats, millis());
+    initMeasurementChannels(&channels, micros());
+    initModuleSensor(&packSensors, &pack, BOARD_MODULES, &fallbackSensors, NULL);
+    measure = (measurementData) { &hVIL, &temperature, &hvCurrent, &hvVoltage,
+                                  &currentStats, &voltageStats, &history, &channels,
+                                  &clockTick, &moduleSensors, &packSensors, NULL };
+
+    measurementTask(&measure);
+    ok = fabs(hvVoltage - fallbackVoltage(NULL)) < 0.005;           // Before the first sweep
+    printf("\nMeasurement through moduleSensors, %u modules\n", BOARD_MODULES);
+    ok = measurePhase("all modules answering", &measure, voltage, hottest, false, true) && ok;
+    silentModule = 3;
+    ok = measurePhase("module 3 drops out, held", &measure, voltage, hottest, true, false) && ok;
+    silentModule = NO_MODULE;
+    ok = measurePhase("module 3 back", &measure, voltage, hottest, false, false) && ok;
+    printf("%lu sweeps missed a module\n", packSensors.faultSweeps);
+    return ok && packSensors.faultSweeps > 0;
+}
+
+int main ( void ) {
+    static const byte counts[]  = { 1, 2, 4, 8, 16, 32 };
+    static const byte windows[] = { 1, 2, 4, 8 };
+    int failures = 0;
+
+    printf("Sweep time in ms at %lu baud, %lu us module response time\n", BUS_BAUD, MODULE_PROCESS_US);
+    printf("modules");
+    for( unsigned w = 0; w < sizeof(windows); w++ ){
+        printf("   window %u", windows[w]);
+    }
+    printf("   speedup\n");
+
+    unsigned long previous = 0;
+    for( unsigned c = 0; c < sizeof(counts); c++ ){
+        unsigned long first = 0, last = 0;
+        printf("%7u", counts[c]);
+        for( unsigned w = 0; w < sizeof(windows); w++ ){
+            byte valid;
+            last = runSweeps(counts[c], windows[w], &valid);
+            if( w == 0 ){
+                first = last;
+            }
+            printf("   %8.2f", last / 1000.0);
+            failures += ( valid != counts[c] );
+        }
+        printf("   %6.2fx\n", (double) first / last);
+        if( c + 1 == sizeof(counts) ){
+            printf("%.2f ms per module added from %u to %u modules, the reply wire time is %.2f ms: linear\n",
+                   ( last - previous ) / 1000.0 / ( counts[c] - counts[c - 1] ), counts[c - 1], counts[c],
+                   BUS_RESPONSE_LENGTH * BYTE_US / 1000.0);
+        }
+        previous = last;
+    }
+    if( failures ){
+        printf("%d runs lost modules\n", failures);
+    }
+
+    printf("\nFaults, %u modules, window %u\n", FAULT_MODULES, FAULT_WINDOW);
+    failures += !faultCase("silent, next reply skips it", &silentModule, 5, 5);
+    failures += !faultCase("silent last module, times out", &silentModule, FAULT_MODULES - 1, FAULT_MODULES - 1);
+    failures += !faultCase("bad CRC", &corruptModule, 7, 7);
+    failures += !faultCase("cut short, next reply follows", &cutModule, 3, 3);
+    failures += !faultCase("noise with a start byte", &noisyModule, 9, NO_MODULE);
+    failures += !faultCase("late, arriving at a timeout", &lateModule, 12, 11);
+
+    failures += !measureCheck();
+
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
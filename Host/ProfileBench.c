@@ -0,0 +1,174 @@
+/* Host check of the sampling profiler in StarterFile/Profiler.c
+ *
+ * Runs the measurement, state of charge and alarm tasks of one board on the
+ * virtual clock, in turns without the profiler and with it, and reports
+ * how much the sampling slowed the fastest run down. That difference is
+ * smaller than the run to run noise of the host, so it is only reported,
+ * next to the spread of the plain runs. The overhead that is checked is
+ * the sampling's own: SIGPROF is raised HANDLER_CALLS times to time one
+ * delivery of the handler, and the samples a run took at that cost are
+ * set against the run's time. The profile of the
+ * profiled runs is written out in the same format profileMonitor() sends
+ * over serial, so the whole path down to Host/profsym.py can be checked
+ * without a board.
+ * On the host SIGPROF stands in for Timer4; the AVR interrupt is fixed
+ * assembly, see its cost in Profiler.c.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -c -IHost Host/Arduino.cpp -o /tmp/Arduino.o
+ *   gcc -O2 -IHost -IStarterFile Host/ProfileBench.c StarterFile/Profiler.c \
+ *       StarterFile/Measurement.c StarterFile/Alarm.c StarterFile/StateOfCharge.c \
+ *       StarterFile/Statistics.c StarterFile/History.c StarterFile/Latency.c StarterFile/Capture.c \
+ *       -x c++ StarterFile/Gpio.cpp -x none /tmp/Arduino.o -lm -lstdc++ -o /tmp/ProfileBench
+ *   /tmp/ProfileBench [dump file, default /tmp/profile.txt]
+ *   python3 Host/profsym.py /tmp/profile.txt /tmp/ProfileBench --nm nm
+ */
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include "Arduino.h"
+#include "Measurement.h"
+#include "Alarm.h"
+#include "StateOfCharge.h"
+#include "Profiler.h"
+
+#define RUN_SECONDS     14400UL     // Simulated seconds per run
+#define RUNS            3           // Timed runs each way, the fastest counts
+#define STEP_US         500UL       // One scheduler pass
+#define MAX_OVERHEAD    3.0         // Percent, the profiler must stay cheap enough for production units
+#define HANDLER_CALLS   200000UL    // Signals raised to time the handler
+
+/* One board, wired the way setup() wires it*/
+static bool hVIL;
+static float temperature, hvCurrent, hvVoltage, stateOfCharge;
+static channelStats currentStats, voltageStats;
+static trendHistory history;
+static channelTable channels;
+static byte clockTick;
+static byte hVoltInterlock, overCurrent, hVoltOutofRange;
+static unsigned long alarmStamp;
+static float currentTimeToLimit, voltageTimeToLimit;
+static bool alarmAcknowledge;
+static latencyTrace latency;
+static measurementData measure;
+static alarmData alarm;
+static stateOfChargeData charge;
+
+static FILE* dump;
+
+static double cpuSeconds ( void ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void emitLine ( const char* line ) {
+    fputs(line, dump);
+}
+
+static void startBoard ( void ) {
+    hostSetMicros(0);
+    memset(&history, 0, sizeof(history));
+    memset(&latency, 0, sizeof(latency));
+    stateOfCharge = FULL;
+    clockTick = 0;
+
+    initChannelStats(&currentStats, millis());
+    initChannelStats(&voltageStats, millis());
+    initMeasurementChannels(&channels, micros());
+    measure = (measurementData) { &hVIL, &temperature, &hvCurrent, &hvVoltage,
+                                  &currentStats, &voltageStats, &history, &channels,
+                                  &clockTick, &simulatedSensors, &measure, NULL };
+    alarm = (alarmData) { &hVoltInterlock, &overCurrent, &hVoltOutofRange,
+                          &hVIL, &hvCurrent, &hvVoltage, &channels, &alarmStamp, &latency,
+                          &currentStats, &voltageStats, &currentTimeToLimit, &voltageTimeToLimit, &alarmAcknowledge };
+    charge = (stateOfChargeData) { &stateOfCharge, &currentStats, PACK_CAPACITY, micros() };
+}
+
+/* CPU seconds one SIGPROF delivery and profiler sample take. The handler
+ * stays installed after profilerStop, only the timer is stopped.*/
+static double handlerSeconds ( void ) {
+    double start;
+
+    profilerStart();
+    profilerStop();
+    start = cpuSeconds();
+    for( unsigned long i = 0; i < HANDLER_CALLS; i++ ){
+        raise(SIGPROF);
+    }
+    return ( cpuSeconds() - start ) / HANDLER_CALLS;
+}
+
+/* CPU seconds one run of the board takes*/
+static double runBoard ( void ) {
+    double start = cpuSeconds();
+
+    startBoard();
+    for( unsigned long long us = 0; us < RUN_SECONDS * 1000000ULL; us += STEP_US ){
+        measurementTask(&measure);
+        if( us > 0 && us % 1000000ULL == 0 ){
+            clockTick = ( clockTick + 1 ) % 18;
+            stateOfChargeTask(&charge);
+            alarmTask(&alarm);
+        }
+        hostAdvanceMicros(STEP_US);
+    }
+    return cpuSeconds() - start;
+}
+
+int main ( int argc, char** argv ) {
+    const char* path = ( argc > 1 ) ? argv[1] : "/tmp/profile.txt";
+    unsigned long samples = 0;
+    double plain = 1e9, profiled = 1e9, slowest = 0, difference, overhead, handler, seconds;
+
+    runBoard();                                                     // Warm the caches so both timed runs start alike
+    profilerClear();
+    for( byte run = 0; run < RUNS; run++ ){
+        seconds = runBoard();
+        if( seconds < plain ){
+            plain = seconds;
+        }
+        if( seconds > slowest ){
+            slowest = seconds;
+        }
+        profilerStart();
+        seconds = runBoard();
+        profilerStop();
+        if( seconds < profiled ){
+            profiled = seconds;
+        }
+    }
+
+    for( unsigned int b = 0; b < PROFILE_BUCKETS; b++ ){
+        samples += profile.count[b];
+    }
+    samples += profile.outside;
+    difference = 100.0 * ( profiled - plain ) / plain;
+
+    printf("%lu simulated seconds, fastest of %d runs: %.3f s without the profiler, %.3f s with it, %+.2f%%\n",
+           RUN_SECONDS, RUNS, plain, profiled, difference);
+    printf("  the plain runs alone spread %.2f%%, the difference is not checked\n", 100.0 * ( slowest - plain ) / plain);
+    printf("%lu samples at %d Hz, %u above the %d KB the buckets cover\n",
+           samples, PROFILE_HZ, (unsigned int) profile.outside,
+           ( PROFILE_BUCKETS << PROFILE_BUCKET_SHIFT ) / 1024);
+
+    dump = fopen(path, "w");
+    if( dump == NULL ){
+        printf("could not write %s\n", path);
+        return 1;
+    }
+    profileReport(&emitLine);
+    fclose(dump);
+    printf("profile in %s\n", path);
+
+    handler = handlerSeconds();
+    overhead = 100.0 * samples / RUNS * handler / profiled;
+    printf("%.2f us per sample, %lu samples per run: %.3f%% of a run in the profiler\n",
+           handler * 1e6, samples / RUNS, overhead);
+    if( overhead > MAX_OVERHEAD ){
+        printf("profiler overhead over %.1f%%\n", MAX_OVERHEAD);
+        return 1;
+    }
+    return samples > 0 ? 0 : 1;
+}
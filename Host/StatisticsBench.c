@@ -0,0 +1,127 @@
+/* Host benchmark for the sliding-window statistics in StarterFile/Statistics.c
+ *
+ * Feeds a 1 kHz synthetic current waveform through one channel for ten
+ * simulated minutes, reports the cost per update and compares the final
+ * 1 s, 10 s and 60 s results and the trend against a brute-force pass over
+ * the same samples.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -c -IHost Host/Arduino.cpp -o /tmp/Arduino.o
+ *   gcc -O2 -IHost -IStarterFile Host/StatisticsBench.c StarterFile/Statistics.c \
+ *       /tmp/Arduino.o -lm -lstdc++ -o /tmp/StatisticsBench && /tmp/StatisticsBench
+ */
+#include <stdio.h>
+#include <time.h>
+#include "Arduino.h"
+#include "Statistics.h"
+
+#define RATE_HZ       1000UL
+#define RUN_SECONDS   600UL
+#define SAMPLES       ( RATE_HZ * RUN_SECONDS )
+
+static float history[SAMPLES];
+
+static double nowSeconds ( void ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float sampleAt ( unsigned long i ) {                         // Drive-like current: slow swing, ripple and spikes
+    float t = (float) i / RATE_HZ;
+    float value = 40.0f * sinf(t * 0.05f) + 5.0f * sinf(t * 50.0f);
+    if( i % 7919 == 0 ){
+        value += 120.0f;
+    }
+    return value;
+}
+
+/* Brute force over the samples the window covers: completed slots plus the open one*/
+static void bruteForce ( const channelStats* stats, byte window, unsigned long last,
+                         float* minimum, float* maximum, float* mean, float* rms ) {
+    const slidingWindow* w = &stats->window[window];
+    unsigned long firstMs = w->slotStart - w->filled * w->slotPeriod;
+    double sum = 0, sumSquares = 0;
+    unsigned long count = 0;
+
+    *minimum = INFINITY;
+    *maximum = -INFINITY;
+    for( unsigned long i = 0; i <= last; i++ ){
+        if( i * 1000 / RATE_HZ < firstMs ){
+            continue;
+        }
+        if( history[i] < *minimum ) *minimum = history[i];
+        if( history[i] > *maximum ) *maximum = history[i];
+        sum += history[i];
+        sumSquares += (double) history[i] * history[i];
+        count++;
+    }
+    *mean = (float) ( sum / count );
+    *rms = (float) sqrt(sumSquares / count);
+}
+
+/* Brute force trend: the point means of the last TREND_POINTS whole periods
+ * before the one last is in, fitted in double*/
+static void bruteForceTrend ( unsigned long last, float low, float high, float* slope, float* timeToLimit ) {
+    unsigned long open = last * 1000 / RATE_HZ / TREND_POINT_PERIOD;
+    double sumT = 0, sumV = 0, sumTT = 0, sumTV = 0, n = TREND_POINTS;
+
+    for( unsigned long p = open - TREND_POINTS; p < open; p++ ){
+        double t = ( p * TREND_POINT_PERIOD + TREND_POINT_PERIOD / 2 ) / 1000.0;
+        double v = 0;
+        for( unsigned long i = p * TREND_POINT_PERIOD * RATE_HZ / 1000; i < ( p + 1 ) * TREND_POINT_PERIOD * RATE_HZ / 1000; i++ ){
+            v += history[i];
+        }
+        v /= TREND_POINT_PERIOD * RATE_HZ / 1000;
+        sumT += t;
+        sumV += v;
+        sumTT += t * t;
+        sumTV += t * v;
+    }
+    double b = ( n * sumTV - sumT * sumV ) / ( n * sumTT - sumT * sumT );
+    double end = open * TREND_POINT_PERIOD / 1000.0;
+    double fitted = sumV / n + b * ( end - sumT / n );
+    *slope = (float) b;
+    *timeToLimit = b > 0 ? (float) ( ( high - fitted ) / b ) : b < 0 ? (float) ( ( low - fitted ) / b ) : TREND_NEVER;
+}
+
+int main ( void ) {
+    static const char* names[STATS_WINDOWS] = { "1 s", "10 s", "60 s" };
+    channelStats stats;
+    int failures = 0;
+
+    for( unsigned long i = 0; i < SAMPLES; i++ ){
+        history[i] = sampleAt(i);
+    }
+
+    initChannelStats(&stats, 0);
+    double start = nowSeconds();
+    for( unsigned long i = 0; i < SAMPLES; i++ ){
+        updateChannelStats(&stats, history[i], i * 1000 / RATE_HZ);
+    }
+    double elapsed = nowSeconds() - start;
+
+    printf("%lu samples at %lu Hz: %.1f ns/update, %zu bytes/channel\n",
+           SAMPLES, RATE_HZ, elapsed * 1e9 / SAMPLES, sizeof(channelStats));
+
+    for( byte w = 0; w < STATS_WINDOWS; w++ ){
+        float minimum, maximum, mean, rms;
+        bruteForce(&stats, w, SAMPLES - 1, &minimum, &maximum, &mean, &rms);
+        bool ok = statsMin(&stats, w) == minimum && statsMax(&stats, w) == maximum &&
+                  fabsf(statsMean(&stats, w) - mean) < 1e-2f && fabsf(statsRms(&stats, w) - rms) < 1e-2f;
+        printf("%-5s n=%-6lu min %8.3f max %8.3f mean %8.3f rms %8.3f  %s\n", names[w],
+               statsCount(&stats, w), statsMin(&stats, w), statsMax(&stats, w),
+               statsMean(&stats, w), statsRms(&stats, w), ok ? "ok" : "MISMATCH");
+        failures += !ok;
+    }
+
+    float slope, timeToLimit;
+    bruteForceTrend(SAMPLES - 1, -100.0f, 100.0f, &slope, &timeToLimit);
+    bool ok = fabsf(statsSlope(&stats) - slope) < 1e-3f &&
+              fabsf(statsTimeToLimit(&stats, -100.0f, 100.0f) - timeToLimit) < 1e-2f * timeToLimit;
+    printf("trend n=%-6u slope %8.4f/s (brute %8.4f), to a 100 limit in %8.1f s (brute %8.1f)  %s\n",
+           stats.trend.filled, statsSlope(&stats), slope, statsTimeToLimit(&stats, -100.0f, 100.0f),
+           timeToLimit, ok ? "ok" : "MISMATCH");
+    failures += !ok;
+    return failures ? 1 : 0;
+}
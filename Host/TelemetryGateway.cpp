@@ -0,0 +1,631 @@
+/* Host telemetry gateway for BMS units streaming StarterFile/Telemetry.h frames
+ *
+ * One thread multiplexes every serial link with epoll. Each link has a
+ * receive buffer and a log batch, both allocated at start up; bytes are
+ * read straight into the receive buffer and frames are decoded where they
+ * lie, so nothing is copied on the way except the frame itself into the
+ * log batch. Only a partial frame left at the end of a read is moved, back
+ * to the front of the buffer. Bytes that do not start a frame with a good
+ * crc are skipped one at a time until the stream is back in step, so debug
+ * text on the same port is harmless.
+ *
+ * The newest values of every unit live in a table of seqlock slots: the
+ * gateway thread is the only writer of a slot and readers on any thread
+ * take a consistent copy without a lock, retrying if a write overlapped.
+ * Log batches are written to one file per unit when full and once a
+ * second, as the raw frames, which this parser reads back.
+ *
+ * With --load the gateway emulates the units itself: every unit gets a
+ * pseudo terminal, the gateway opens the slave side like a serial port and
+ * generator threads write frames to the master side at the unit rate, with
+ * the send time in the stamp field. The run reports parse throughput, the
+ * time from a read returning to the table holding its frames, the time
+ * from a unit sending a frame to the table holding it, and checks that
+ * every frame arrived and no reader ever saw a torn slot. The parser is
+ * also timed alone on an in-memory stream.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -pthread -IHost -IStarterFile -x c++ Host/TelemetryGateway.cpp Host/Arduino.cpp \
+ *       -x c StarterFile/Telemetry.c StarterFile/Latency.c -o /tmp/TelemetryGateway
+ *   /tmp/TelemetryGateway --load 300 [--rate 100] [--seconds 10] [--logs /tmp/telemetry]
+ *   /tmp/TelemetryGateway [--baud 9600] [--logs dir] /dev/ttyACM0 /dev/ttyUSB0 ...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Arduino.h"
+#include "Telemetry.h"
+#include "Latency.h"
+
+#define RX_BUFFER           4096        // Bytes read from a link at once
+#define LOG_BATCH           16384       // Frames collected per unit before a log write
+#define LOG_FLUSH_MS        1000        // Longest a frame waits in a batch
+#define MAX_EVENTS          256
+#define PARSE_STREAM        ( 4 * 1024 * 1024 )   // In-memory stream for timing the parser alone
+#define NOISE_EVERY         997         // Frames between bursts of junk from the load generator
+#define READER_PAUSE_US     50          // Table reader rest between sweeps, leaves the gateway a core on small hosts
+
+/* Latest values of one unit*/
+typedef struct latestValuesData {
+    uint32_t stamp;                     // Unit micros(), or the send time under --load
+    float current;
+    float voltage;
+    float temperature;
+    float stateOfCharge;
+    uint8_t status;
+    uint8_t faults;
+    uint8_t sequence;
+    uint32_t frames;                    // Frames received from the unit
+    uint64_t arrival;                   // Gateway clock, ns, when the frame's last read returned
+} latestValues;
+
+/* Seqlock slot. The version is odd while the writer is in the middle of an
+ * update; the payload is kept in atomic words so concurrent reads are
+ * defined, and the fences order them against the version.*/
+#define SLOT_WORDS  ( ( sizeof(latestValues) + 3 ) / 4 )
+
+typedef struct alignas(64) tableSlotData {     // Own cache lines, units do not slow each other's readers
+    std::atomic<uint32_t> version;
+    std::atomic<uint32_t> words[SLOT_WORDS];
+} tableSlot;
+
+static void publish ( tableSlot* slot, const latestValues* values ) {
+    uint32_t words[SLOT_WORDS] = { 0 };
+    uint32_t version = slot->version.load(std::memory_order_relaxed);
+
+    memcpy(words, values, sizeof(latestValues));
+    slot->version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for( unsigned int i = 0; i < SLOT_WORDS; i++ ){
+        slot->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot->version.store(version + 2, std::memory_order_release);
+}
+
+/* Consistent copy of a slot, returns how many times it had to retry*/
+static unsigned int readSlot ( const tableSlot* slot, latestValues* values ) {
+    uint32_t words[SLOT_WORDS];
+    unsigned int retries = 0;
+
+    for( ;; ){
+        uint32_t before = slot->version.load(std::memory_order_acquire);
+        if( ( before & 1 ) == 0 ){
+            for( unsigned int i = 0; i < SLOT_WORDS; i++ ){
+                words[i] = slot->words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if( slot->version.load(std::memory_order_relaxed) == before ){
+                break;
+            }
+        }
+        if( ++retries % 64 == 0 ){                              // Writer was preempted mid update, let it finish
+            std::this_thread::yield();
+        }
+    }
+    memcpy(values, words, sizeof(latestValues));
+    return retries;
+}
+
+/* One serial link*/
+typedef struct telemetryLinkData {
+    int fd;
+    int logFd;
+    char name[64];
+    tableSlot* slot;
+
+    uint8_t rx[RX_BUFFER];
+    size_t used;
+    uint8_t log[LOG_BATCH];
+    size_t logged;
+
+    uint8_t lastSequence;
+    uint32_t frames;
+    unsigned long long bytes;
+    unsigned long crcErrors;            // Frames with a start and a bad crc or version
+    unsigned long long skipped;         // Bytes dropped to get back in step
+    unsigned long lost;                 // Sequence numbers that never arrived
+    unsigned long logWrites;
+} telemetryLink;
+
+/* Gateway wide counters*/
+static latencyHistogram readToTable;    // ns
+static latencyHistogram sendToTable;    // us, --load only
+static bool stampIsSendTime = false;
+static unsigned long long logBytes = 0;
+static unsigned long long parseNs = 0;
+static volatile sig_atomic_t stopRequested = 0;
+
+static uint64_t clockNs ( void ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t threadCpuNs ( void ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t getLong ( const uint8_t* at ) {
+    return at[0] | ( at[1] << 8 ) | ( at[2] << 16 ) | ( (uint32_t) at[3] << 24 );
+}
+
+static float getFloat ( const uint8_t* at ) {
+    uint32_t bits = getLong(at);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void flushLog ( telemetryLink* link ) {
+    if( link->logged == 0 ){
+        return;
+    }
+    if( link->logFd >= 0 && write(link->logFd, link->log, link->logged) == (ssize_t) link->logged ){
+        logBytes += link->logged;
+        link->logWrites++;
+    }
+    link->logged = 0;
+}
+
+/* Decodes every whole frame in the receive buffer where it lies and keeps
+ * a trailing partial frame for the next read*/
+static void parseLink ( telemetryLink* link, uint64_t arrival ) {
+    size_t at = 0;
+
+    while( link->used - at >= TELEMETRY_FRAME_LENGTH ){
+        const uint8_t* frame = &link->rx[at];
+
+        if( frame[0] != TELEMETRY_SOF1 || frame[1] != TELEMETRY_SOF2 ){
+            const uint8_t* next = (const uint8_t*) memchr(frame + 1, TELEMETRY_SOF1, link->used - at - 1);
+            size_t skip = next ? (size_t) ( next - frame ) : link->used - at;
+            link->skipped += skip;
+            at += skip;
+            continue;
+        }
+        if( frame[TELEMETRY_AT_VERSION] != TELEMETRY_VERSION ||
+            telemetryCrc(&frame[TELEMETRY_AT_VERSION], TELEMETRY_AT_CRC - TELEMETRY_AT_VERSION) !=
+            (unsigned int) ( frame[TELEMETRY_AT_CRC] | ( frame[TELEMETRY_AT_CRC + 1] << 8 ) ) ){
+            link->crcErrors++;
+            link->skipped++;
+            at++;
+            continue;
+        }
+
+        latestValues values;
+        values.stamp         = getLong(&frame[TELEMETRY_AT_STAMP]);
+        values.current       = getFloat(&frame[TELEMETRY_AT_CURRENT]);
+        values.voltage       = getFloat(&frame[TELEMETRY_AT_VOLTAGE]);
+        values.temperature   = getFloat(&frame[TELEMETRY_AT_TEMP]);
+        values.stateOfCharge = getFloat(&frame[TELEMETRY_AT_SOC]);
+        values.status        = frame[TELEMETRY_AT_STATUS];
+        values.faults        = frame[TELEMETRY_AT_FAULTS];
+        values.sequence      = frame[TELEMETRY_AT_SEQUENCE];
+        values.frames        = ++link->frames;
+        values.arrival       = arrival;
+        if( link->frames > 1 ){
+            link->lost += (uint8_t) ( values.sequence - link->lastSequence - 1 );
+        }
+        link->lastSequence = values.sequence;
+        publish(link->slot, &values);
+
+        uint64_t published = clockNs();
+        recordLatency(&readToTable, 0, published - arrival);
+        if( stampIsSendTime ){
+            recordLatency(&sendToTable, 0, (uint32_t) ( published / 1000 - values.stamp ));   // Stamp is 32 bit, wraps
+        }
+
+        if( link->logged + TELEMETRY_FRAME_LENGTH > LOG_BATCH ){
+            flushLog(link);
+        }
+        memcpy(&link->log[link->logged], frame, TELEMETRY_FRAME_LENGTH);
+        link->logged += TELEMETRY_FRAME_LENGTH;
+        at += TELEMETRY_FRAME_LENGTH;
+    }
+    if( at > 0 ){
+        memmove(link->rx, &link->rx[at], link->used - at);
+        link->used -= at;
+    }
+}
+
+/* Reads whatever the link has, returns false once it is closed*/
+static bool readLink ( telemetryLink* link ) {
+    for( ;; ){
+        ssize_t got = read(link->fd, &link->rx[link->used], RX_BUFFER - link->used);
+        if( got > 0 ){
+            uint64_t arrival = clockNs();
+            link->used += got;
+            link->bytes += got;
+            parseLink(link, arrival);
+            parseNs += clockNs() - arrival;
+            continue;
+        }
+        if( got < 0 && ( errno == EAGAIN || errno == EINTR ) ){
+            return true;
+        }
+        return false;                                           // 0 or EIO: the other end went away
+    }
+}
+
+static bool openLog ( telemetryLink* link, const char* directory ) {
+    char path[512];
+
+    snprintf(path, sizeof(path), "%s/%s.bin", directory, link->name);
+    link->logFd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if( link->logFd < 0 ){
+        printf("could not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static bool setRaw ( int fd, unsigned long baud ) {
+    struct termios tio;
+
+    if( tcgetattr(fd, &tio) != 0 ){
+        return false;
+    }
+    cfmakeraw(&tio);
+    if( baud != 0 ){
+        speed_t speed = baud == 115200 ? B115200 : baud == 57600 ? B57600 : baud == 38400 ? B38400 :
+                        baud == 19200 ? B19200 : B9600;
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+    }
+    tio.c_cc[VMIN] = 1;                                         // With VMIN 0 an empty read returns 0, not EAGAIN
+    tio.c_cc[VTIME] = 0;
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+/* Load generator: units emulated on the master side of pseudo terminals*/
+typedef struct unitEmulatorData {
+    int master;
+    uint8_t sequence;
+    uint64_t nextNs;
+    unsigned long sent;
+    unsigned long blocked;              // Frames the pty would not take, the unit's own transmit overrun
+} unitEmulator;
+
+static void generate ( std::vector<unitEmulator>* units, unsigned int first, unsigned int step,
+                       uint64_t periodNs, uint64_t endNs ) {
+    uint8_t frame[TELEMETRY_FRAME_LENGTH];
+    static const uint8_t junk[] = "BMS debug: measure 1.00 A\r\n";
+
+    for( ;; ){
+        uint64_t now = clockNs();
+        uint64_t wake = endNs;
+
+        if( now >= endNs ){
+            return;
+        }
+        for( unsigned int i = first; i < units->size(); i += step ){
+            unitEmulator* unit = &( *units )[i];
+            while( unit->nextNs <= now ){
+                float current = unit->sequence % 100;                       // Readers check voltage == current + 300
+                buildTelemetryFrame(frame, unit->sequence, (unsigned long) ( now / 1000 ) & 0xFFFFFFFFUL,
+                                    current, current + 300.0f, 25.0f, 50.0f, 0x03, 0);
+                if( ( unit->sent + i ) % NOISE_EVERY == NOISE_EVERY - 1 ){      // Staggered so short runs see junk too
+                    ssize_t ignored = write(unit->master, junk, sizeof(junk) - 1);
+                    (void) ignored;
+                }
+                if( write(unit->master, frame, sizeof(frame)) == (ssize_t) sizeof(frame) ){
+                    unit->sent++;
+                }
+                else {
+                    unit->blocked++;
+                }
+                unit->sequence++;
+                unit->nextNs += periodNs;
+            }
+            if( unit->nextNs < wake ){
+                wake = unit->nextNs;
+            }
+        }
+        struct timespec until = { (time_t) ( wake / 1000000000ULL ), (long) ( wake % 1000000000ULL ) };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+    }
+}
+
+/* Table reader: sweeps copies of every slot, as a dashboard or uplink
+ * would but much more often, and checks each copy is one whole frame*/
+static std::atomic<bool> readersStop(false);
+static std::atomic<unsigned long long> tableReads(0), tableRetries(0), tornReads(0);
+
+static void tableReader ( const tableSlot* slots, unsigned int count ) {
+    unsigned long long reads = 0, retries = 0, torn = 0;
+
+    while( !readersStop.load(std::memory_order_relaxed) ){
+        for( unsigned int i = 0; i < count; i++ ){
+            latestValues values;
+            retries += readSlot(&slots[i], &values);
+            if( values.frames != 0 && values.voltage != values.current + 300.0f ){
+                torn++;
+            }
+            reads++;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(READER_PAUSE_US));
+    }
+    tableReads += reads;
+    tableRetries += retries;
+    tornReads += torn;
+}
+
+/* Parser alone, on a stream of frames with junk between some of them*/
+static void timeParser ( void ) {
+    std::vector<uint8_t> stream;
+    static telemetryLink link;
+    tableSlot slot;
+    static const uint8_t junk[] = "BMS debug: measure 1.00 A\r\n";
+    unsigned long frames = 0;
+
+    stream.reserve(PARSE_STREAM + 64);
+    while( stream.size() + TELEMETRY_FRAME_LENGTH + sizeof(junk) < PARSE_STREAM ){
+        uint8_t frame[TELEMETRY_FRAME_LENGTH];
+        buildTelemetryFrame(frame, (byte) frames, frames, frames % 100, frames % 100 + 300.0f, 25.0f, 50.0f, 0x03, 0);
+        stream.insert(stream.end(), frame, frame + sizeof(frame));
+        if( ++frames % NOISE_EVERY == 0 ){
+            stream.insert(stream.end(), junk, junk + sizeof(junk) - 1);
+        }
+    }
+
+    memset(&link, 0, sizeof(link));
+    link.logFd = -1;
+    link.slot = &slot;
+    slot.version = 0;
+    uint64_t start = threadCpuNs();
+    for( size_t at = 0; at < stream.size(); ){                  // Feed it in read sized pieces, as a link would
+        size_t piece = stream.size() - at < RX_BUFFER - link.used ? stream.size() - at : RX_BUFFER - link.used;
+        memcpy(&link.rx[link.used], &stream[at], piece);
+        link.used += piece;
+        at += piece;
+        parseLink(&link, 0);
+        link.logged = 0;
+    }
+    double seconds = ( threadCpuNs() - start ) * 1e-9;
+    memset(&readToTable, 0, sizeof(readToTable));
+
+    printf("parser alone: %lu frames in %.1f MB, %.0f ns/frame, %.0f MB/s, %lu frames decoded, %llu junk bytes skipped\n",
+           frames, stream.size() / 1e6, seconds * 1e9 / link.frames, stream.size() / seconds / 1e6,
+           (unsigned long) link.frames, link.skipped);
+}
+
+static void onSignal ( int number ) {
+    (void) number;
+    stopRequested = 1;
+}
+
+int main ( int argc, char** argv ) {
+    unsigned int loadUnits = 0;
+    unsigned int rate = 100;
+    unsigned int seconds = 10;
+    unsigned long baud = 9600;
+    const char* logDirectory = "/tmp/telemetry";
+    std::vector<const char*> paths;
+    std::vector<unitEmulator> units;
+    int failures = 0;
+
+    for( int i = 1; i < argc; i++ ){
+        if( strcmp(argv[i], "--load") == 0 && i + 1 < argc ){
+            loadUnits = strtoul(argv[++i], NULL, 10);
+        }
+        else if( strcmp(argv[i], "--rate") == 0 && i + 1 < argc ){
+            rate = strtoul(argv[++i], NULL, 10);
+        }
+        else if( strcmp(argv[i], "--seconds") == 0 && i + 1 < argc ){
+            seconds = strtoul(argv[++i], NULL, 10);
+        }
+        else if( strcmp(argv[i], "--baud") == 0 && i + 1 < argc ){
+            baud = strtoul(argv[++i], NULL, 10);
+        }
+        else if( strcmp(argv[i], "--logs") == 0 && i + 1 < argc ){
+            logDirectory = argv[++i];
+        }
+        else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if( loadUnits == 0 && paths.empty() ){
+        printf("usage: %s --load units [--rate hz] [--seconds s] [--logs dir]\n"
+               "       %s [--baud rate] [--logs dir] device ...\n", argv[0], argv[0]);
+        return 2;
+    }
+    if( rate == 0 ){
+        rate = 1;
+    }
+
+    struct rlimit files;                                        // A pty pair and a log per unit
+    if( getrlimit(RLIMIT_NOFILE, &files) == 0 ){
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+    mkdir(logDirectory, 0755);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    timeParser();
+
+    unsigned int linkCount = loadUnits ? loadUnits : paths.size();
+    std::unique_ptr<telemetryLink[]> links(new telemetryLink[linkCount]);
+    std::unique_ptr<tableSlot[]> table(new tableSlot[linkCount]);
+    int epoll = epoll_create1(0);
+
+    stampIsSendTime = loadUnits > 0;
+    units.resize(loadUnits);
+    for( unsigned int i = 0; i < linkCount; i++ ){
+        telemetryLink* link = &links[i];
+        memset(link, 0, sizeof(telemetryLink));
+        link->logFd = -1;
+        link->slot = &table[i];
+        table[i].version = 0;
+        for( unsigned int w = 0; w < SLOT_WORDS; w++ ){
+            table[i].words[w] = 0;
+        }
+
+        if( loadUnits ){
+            units[i].master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+            if( units[i].master < 0 || grantpt(units[i].master) != 0 || unlockpt(units[i].master) != 0 ){
+                printf("could not create pseudo terminal %u: %s\n", i, strerror(errno));
+                return 1;
+            }
+            link->fd = open(ptsname(units[i].master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+            if( link->fd < 0 || !setRaw(link->fd, 0) ){
+                printf("could not open %s: %s\n", ptsname(units[i].master), strerror(errno));
+                return 1;
+            }
+            snprintf(link->name, sizeof(link->name), "unit-%03u", i);
+        }
+        else {
+            const char* base = strrchr(paths[i], '/');
+            link->fd = open(paths[i], O_RDWR | O_NOCTTY | O_NONBLOCK);
+            if( link->fd < 0 || !setRaw(link->fd, baud) ){
+                printf("could not open %s: %s\n", paths[i], strerror(errno));
+                return 1;
+            }
+            snprintf(link->name, sizeof(link->name), "%s", base ? base + 1 : paths[i]);
+        }
+        if( !openLog(link, logDirectory) ){
+            return 1;
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = link;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, link->fd, &event);
+    }
+
+    int flushTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    struct itimerspec every = { { LOG_FLUSH_MS / 1000, ( LOG_FLUSH_MS % 1000 ) * 1000000L },
+                                { LOG_FLUSH_MS / 1000, ( LOG_FLUSH_MS % 1000 ) * 1000000L } };
+    timerfd_settime(flushTimer, 0, &every, NULL);
+    struct epoll_event timerEvent;
+    timerEvent.events = EPOLLIN;
+    timerEvent.data.ptr = NULL;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, flushTimer, &timerEvent);
+
+    std::vector<std::thread> generators;
+    std::thread reader(tableReader, table.get(), linkCount);
+    uint64_t start = clockNs();
+    uint64_t endNs = start + seconds * 1000000000ULL;
+    if( loadUnits ){
+        unsigned int threads = std::thread::hardware_concurrency() > 2 ? std::thread::hardware_concurrency() / 2 : 1;
+        uint64_t periodNs = 1000000000ULL / rate;
+        for( unsigned int i = 0; i < loadUnits; i++ ){          // Spread the units over the period
+            units[i].nextNs = start + periodNs * i / loadUnits;
+        }
+        for( unsigned int t = 0; t < threads; t++ ){
+            generators.push_back(std::thread(generate, &units, t, threads, periodNs, endNs));
+        }
+        printf("%u emulated units, %u frames/s each, %u s, %u generator threads\n", loadUnits, rate, seconds, threads);
+    }
+    else {
+        printf("%u links, logs in %s, ctrl-c to stop\n", linkCount, logDirectory);
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    uint64_t cpuStart = threadCpuNs();
+    uint64_t lastData = clockNs();
+    unsigned long long lastFrames = 0;
+    while( !stopRequested ){
+        int ready = epoll_wait(epoll, events, MAX_EVENTS, 100);
+        uint64_t now = clockNs();
+        for( int e = 0; e < ready; e++ ){
+            telemetryLink* link = (telemetryLink*) events[e].data.ptr;
+            if( link == NULL ){                                 // Flush tick
+                uint64_t expirations;
+                if( read(flushTimer, &expirations, sizeof(expirations)) > 0 ){
+                    unsigned long long frames = 0;
+                    for( unsigned int i = 0; i < linkCount; i++ ){
+                        flushLog(&links[i]);
+                        frames += links[i].frames;
+                    }
+                    if( !loadUnits ){
+                        printf("%llu frames/s\n", frames - lastFrames);
+                        fflush(stdout);
+                    }
+                    lastFrames = frames;
+                }
+                continue;
+            }
+            if( !readLink(link) ){
+                epoll_ctl(epoll, EPOLL_CTL_DEL, link->fd, NULL);
+            }
+            lastData = now;
+        }
+        if( loadUnits && now > endNs && now - lastData > 200000000ULL ){   // Generators done and the links drained
+            break;
+        }
+    }
+    uint64_t cpu = threadCpuNs() - cpuStart;
+    double wall = ( clockNs() - start ) * 1e-9;
+
+    for( std::thread& generator : generators ){
+        generator.join();
+    }
+    readersStop = true;
+    reader.join();
+
+    unsigned long long frames = 0, bytes = 0, skipped = 0, logWrites = 0;
+    unsigned long crcErrors = 0, lost = 0, sent = 0, blocked = 0;
+    for( unsigned int i = 0; i < linkCount; i++ ){
+        flushLog(&links[i]);
+        frames    += links[i].frames;
+        bytes     += links[i].bytes;
+        skipped   += links[i].skipped;
+        crcErrors += links[i].crcErrors;
+        lost      += links[i].lost;
+        logWrites += links[i].logWrites;
+        close(links[i].fd);
+        close(links[i].logFd);
+    }
+    for( unitEmulator& unit : units ){
+        sent    += unit.sent;
+        blocked += unit.blocked;
+        close(unit.master);
+    }
+
+    printf("\n%llu frames, %.1f MB in %.1f s: %.0f frames/s, %.2f MB/s\n",
+           frames, bytes / 1e6, wall, frames / wall, bytes / wall / 1e6);
+    printf("gateway thread %.0f ns CPU per frame, %.0f ns of it parsing and publishing\n",
+           frames ? (double) cpu / frames : 0.0, frames ? (double) parseNs / frames : 0.0);
+    printf("%lu crc errors, %llu bytes skipped, %lu frames missing from the sequence\n", crcErrors, skipped, lost);
+    printf("read-to-table p50 <= %lu ns, p99 <= %lu ns, max %lu ns\n",
+           latencyPercentile(&readToTable, 50), latencyPercentile(&readToTable, 99), readToTable.maximum);
+    if( loadUnits ){
+        printf("send-to-table p50 <= %lu us, p99 <= %lu us, max %lu us\n",
+               latencyPercentile(&sendToTable, 50), latencyPercentile(&sendToTable, 99), sendToTable.maximum);
+        printf("%lu frames sent, %lu refused by a full pty\n", sent, blocked);
+    }
+    printf("table reader: %llu slot reads, %llu retries, %llu torn\n",
+           tableReads.load(), tableRetries.load(), tornReads.load());
+    printf("logs: %.1f MB in %llu batch writes, %.0f frames per write, in %s\n",
+           logBytes / 1e6, logWrites, logWrites ? logBytes / (double) TELEMETRY_FRAME_LENGTH / logWrites : 0.0,
+           logDirectory);
+
+    if( tornReads.load() != 0 ){
+        printf("torn table reads\n");
+        failures++;
+    }
+    if( loadUnits && frames != sent ){
+        printf("%lld frames sent but not parsed\n", (long long) sent - (long long) frames);
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
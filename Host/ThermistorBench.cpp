@@ -0,0 +1,162 @@
+/* Host accuracy report and benchmark for StarterFile/Thermistor.cpp
+ *
+ * Converts every 10 bit ADC code through the flash table and through the
+ * exact formula, and reports the worst and RMS difference over the rated
+ * range of the sensor, where the clamping starts, and the cost per
+ * conversion of each. A Steinhart-Hart sensor is run through the same
+ * table generator, so both ways of describing a thermistor are covered.
+ * The error is also given in ADC codes, the temperature one code step is
+ * worth where it occurs; the divider resolves a tenth of a degree around
+ * 25 C but over a degree per code near 125 C, and the budget follows that.
+ * The constexpr log the tables are built with is checked against log().
+ * Host timings only rank the two paths; on the AVR the float log() alone
+ * is some thousands of cycles.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -IHost -IStarterFile Host/ThermistorBench.cpp StarterFile/Thermistor.cpp \
+ *       -o /tmp/ThermistorBench && /tmp/ThermistorBench
+ */
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "Arduino.h"
+#include "Thermistor.h"
+
+#define RATED_MIN       -40.0       // Celsius, the range the error budget covers
+#define RATED_MAX       125.0
+#define MAX_CODES       0.5         // Worst table error allowed over the rated range, in ADC codes:
+                                    //  no worse than the ADC's own rounding
+#define ROUNDING        0.005       // Celsius, the table's centidegree rounding is always allowed
+#define MAX_LOG_ERROR   1e-12       // Relative, constexpr log against log()
+#define PASSES          20000       // Sweeps of the whole ADC range per timing
+
+/* A 10k 3950 NTC from its data sheet's Steinhart-Hart coefficients*/
+constexpr thermistorModel coefficientSensor =
+    thermistorSteinhartHart(1.009249522e-3, 2.378405444e-4, 2.019202697e-7, THERMISTOR_SERIES);
+constexpr thermistorTable coefficientCurve = makeThermistorTable(coefficientSensor);
+
+constexpr thermistorModel betaSensor =
+    thermistorBeta(THERMISTOR_R0, THERMISTOR_T0, THERMISTOR_BETA, THERMISTOR_SERIES);
+
+static volatile double sink;
+
+static double nowSeconds ( void ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The formula the table stands in for, in double with the library log*/
+static double exactCelsius ( const thermistorModel& model, unsigned int code ) {
+    double lnR = log(model.series * code / ( THERMISTOR_CODES - code ));
+    return 1.0 / ( model.a + model.b * lnR + model.c * lnR * lnR * lnR ) - KELVIN_OFFSET;
+}
+
+/* What the board would run without the table*/
+static float floatCelsius ( unsigned int code ) {
+    float r = (float) THERMISTOR_SERIES * code / ( THERMISTOR_CODES - code );
+    return 1.0f / ( 1.0f / (float) ( THERMISTOR_T0 + KELVIN_OFFSET )
+                    + logf(r / (float) THERMISTOR_R0) / (float) THERMISTOR_BETA ) - (float) KELVIN_OFFSET;
+}
+
+/* Compares lookup against the exact formula over every code and prints the
+ * report. Returns the worst error inside the rated range in ADC codes.*/
+static double accuracy ( const char* name, const thermistorModel& model, int16_t (*lookup)(unsigned int) ) {
+    double worst = 0, worstSteps = 0, squares = 0;
+    unsigned int stepsCode = 0;
+    unsigned int worstCode = 0, rated = 0, first = 0, last = 0;
+    bool monotonic = true;
+    int16_t previous = THERMISTOR_MAX;
+    for( unsigned int code = 1; code < THERMISTOR_CODES; code++ ){
+        double exact = exactCelsius(model, code);
+        int16_t table = lookup(code);
+        if( table > previous ){
+            monotonic = false;
+        }
+        previous = table;
+        if( exact < RATED_MIN || exact > RATED_MAX ){
+            continue;
+        }
+        if( rated == 0 ){
+            first = code;
+        }
+        last = code;
+        rated++;
+        double error = fabs(table * 0.01 - exact);
+        squares += error * error;
+        if( error > worst ){
+            worst = error;
+            worstCode = code;
+        }
+        double step = fabs(exactCelsius(model, code) - exactCelsius(model, code + 1));
+        double steps = fmax(error - ROUNDING, 0.0) / step;
+        if( steps > worstSteps ){
+            worstSteps = steps;
+            stepsCode = code;
+        }
+    }
+    printf("%s\n", name);
+    printf("  rated %.0f to %.0f C: codes %u - %u (%u codes)\n", RATED_MAX, RATED_MIN, first, last, rated);
+    printf("  worst error  %.4f C at code %u (exact %.3f C, table %.2f C)\n", worst, worstCode,
+           exactCelsius(model, worstCode), lookup(worstCode) * 0.01);
+    printf("  rms error    %.4f C\n", sqrt(squares / rated));
+    printf("  worst codes  %.3f codes at code %u (one code is %.3f C there)\n", worstSteps, stepsCode,
+           fabs(exactCelsius(model, stepsCode) - exactCelsius(model, stepsCode + 1)));
+    printf("  ends         code 1 %.2f C (exact %.1f), code %u %.2f C (exact %.1f)\n",
+           lookup(1) * 0.01, exactCelsius(model, 1), THERMISTOR_CODES - 1,
+           lookup(THERMISTOR_CODES - 1) * 0.01, exactCelsius(model, THERMISTOR_CODES - 1));
+    printf("  monotonic    %s\n", monotonic ? "yes" : "NO");
+    return monotonic ? worstSteps : 1e9;
+}
+
+static int16_t coefficientLookup ( unsigned int code ) {
+    return thermistorLookup(&coefficientCurve, code);
+}
+
+template <typename Convert>
+static double nanosPerCode ( Convert convert ) {
+    double start = nowSeconds();
+    double total = 0;
+    for( int pass = 0; pass < PASSES; pass++ ){
+        for( unsigned int code = 1; code < THERMISTOR_CODES; code++ ){
+            total += convert(code);
+        }
+    }
+    sink = total;
+    return ( nowSeconds() - start ) * 1e9 / ( (double) PASSES * ( THERMISTOR_CODES - 1 ) );
+}
+
+int main ( void ) {
+    bool pass = true;
+
+    double logError = 0;
+    for( double x = 1e-3; x < 1e7; x *= 1.01 ){
+        logError = fmax(logError, fabs(thermistorLog(x) - log(x)) / fmax(1.0, fabs(log(x))));
+    }
+    printf("constexpr log  worst error %.2e over 1e-3 - 1e7\n", logError);
+    pass = pass && logError <= MAX_LOG_ERROR;
+
+    printf("table          %u entries, one every %u codes, %u bytes of flash\n\n",
+           THERMISTOR_SEGMENTS + 1, 1u << THERMISTOR_SHIFT, (unsigned int) sizeof(thermistorTable));
+
+    double betaWorst = accuracy("beta sensor (pack, StarterFile/Thermistor.cpp)", betaSensor, thermistorCentidegrees);
+    double coefficientWorst = accuracy("Steinhart-Hart sensor", coefficientSensor, coefficientLookup);
+    pass = pass && betaWorst <= MAX_CODES && coefficientWorst <= MAX_CODES;
+
+    double floatError = 0;
+    for( unsigned int code = 1; code < THERMISTOR_CODES; code++ ){
+        double exact = exactCelsius(betaSensor, code);
+        if( exact >= RATED_MIN && exact <= RATED_MAX ){
+            floatError = fmax(floatError, fabs(floatCelsius(code) - exact));
+        }
+    }
+    printf("\nfloat formula  worst error %.5f C over the rated range\n", floatError);
+
+    double table = nanosPerCode([] ( unsigned int code ) { return (double) thermistorCentidegrees(code); });
+    double single = nanosPerCode([] ( unsigned int code ) { return (double) floatCelsius(code); });
+    double exact = nanosPerCode([] ( unsigned int code ) { return exactCelsius(betaSensor, code); });
+    printf("\nper conversion table %.2f ns, float formula %.2f ns, double formula %.2f ns\n", table, single, exact);
+
+    printf("%s (budget %.2f codes)\n", pass ? "PASS" : "FAIL", MAX_CODES);
+    return pass ? 0 : 1;
+}
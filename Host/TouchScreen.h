@@ -0,0 +1,25 @@
+#ifndef HOST_TOUCHSCREEN_H_
+#define HOST_TOUCHSCREEN_H_
+
+/* Host stand-in for the resistive touch screen. getPoint() returns whatever
+ * the host program put in point; z stays 0, no touch, unless it does.*/
+
+#include <stdint.h>
+
+class TSPoint {
+ public:
+    TSPoint (void) : x(0), y(0), z(0) {}
+    int16_t x, y, z;
+};
+
+class TouchScreen {
+ public:
+    TouchScreen (uint8_t xp, uint8_t yp, uint8_t xm, uint8_t ym, uint16_t rx) {
+        (void) xp; (void) yp; (void) xm; (void) ym; (void) rx;
+    }
+    TSPoint getPoint (void) { return point; }
+
+    TSPoint point;                      // Host only, raw reading to report
+};
+
+#endif    // HOST_TOUCHSCREEN_H_
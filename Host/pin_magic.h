@@ -0,0 +1,28 @@
+#ifndef HOST_PIN_MAGIC_H_
+#define HOST_PIN_MAGIC_H_
+
+/* Host stand-in for the shield bus macros. Bytes go to the Elegoo_TFTLCD
+ * mock, which counts them and decodes the commands it knows.*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void hostLcdSelect (bool active);
+void hostLcdCommandData (bool data);
+void hostLcdWrite8 (uint8_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define CS_ACTIVE   hostLcdSelect(true)
+#define CS_IDLE     hostLcdSelect(false)
+#define CD_COMMAND  hostLcdCommandData(false)
+#define CD_DATA     hostLcdCommandData(true)
+#define write8(d)   hostLcdWrite8(d)
+
+#endif    // HOST_PIN_MAGIC_H_
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Symbolizes a dump from StarterFile/Profiler.c against the program's ELF.
+
+Capture the serial output of profileMonitor() (or a host program's
+profileReport()) to a file and run:
+
+    Host/profsym.py capture.txt sketch.elf
+    Host/profsym.py capture.txt sketch.elf --nm avr-nm --buckets
+
+The last PROFILE ... END block in the capture is used, so a log with
+other serial output in it is fine. Each bucket covers a fixed run of
+flash; a function that shares a bucket with others gets a share of its
+samples in proportion to how many of the bucket's bytes it covers, so
+small neighbouring functions are estimates, large ones are exact.
+"""
+
+import argparse
+import bisect
+import re
+import subprocess
+import sys
+
+HEADER = re.compile(r"PROFILE buckets=(\d+) shift=(\d+) hz=(\d+) outside=(\d+)")
+
+
+def read_dump(stream):
+    """Returns (layout, counts) of the last complete block in the capture."""
+    layout, counts, block = None, None, None
+    for line in stream:
+        line = line.strip()
+        match = HEADER.search(line)
+        if match:
+            block = (dict(zip(("buckets", "shift", "hz", "outside"), map(int, match.groups()))), {})
+            continue
+        if block is None:
+            continue
+        if line == "END":
+            layout, counts = block
+            block = None
+            continue
+        fields = line.split()
+        if len(fields) == 2:
+            try:
+                block[1][int(fields[0], 16)] = int(fields[1])
+            except ValueError:
+                block = None                        # Serial noise inside a block, wait for the next one
+    if layout is None:
+        sys.exit("no complete PROFILE block in the capture")
+    return layout, counts
+
+
+def read_symbols(nm, elf):
+    """Returns the code symbols as sorted (start, end, name), counted from where bucket 0 starts."""
+    output = subprocess.run([nm, "-C", "-n", "-S", "--defined-only", elf],
+                            check=True, capture_output=True, text=True).stdout
+    raw, origin = [], 0
+    for line in output.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and len(fields[2]) == 1:
+            address, size, kind, name = int(fields[0], 16), int(fields[1], 16), fields[2], fields[3]
+        elif len(fields) >= 3 and len(fields[1]) == 1:
+            address, size, kind, name = int(fields[0], 16), None, fields[1], " ".join(fields[2:])
+        else:
+            continue
+        if name == "__executable_start":            # Host builds count from here, AVR from 0
+            origin = address
+        if kind in "tTwW":
+            raw.append((address, size, name))
+    symbols = []
+    for i, (address, size, name) in enumerate(raw):
+        if size is None or size == 0:               # Assembly labels have no size, run to the next symbol
+            size = raw[i + 1][0] - address if i + 1 < len(raw) else 2
+        if size > 0:
+            symbols.append((address - origin, address - origin + size, name))
+    symbols.sort()
+    return symbols
+
+
+def attribute(counts, symbols, shift):
+    """Spreads every bucket's samples over the functions that overlap it."""
+    starts = [start for start, _, _ in symbols]
+    shares, detail = {}, {}
+    for bucket, count in sorted(counts.items()):
+        low, high = bucket << shift, (bucket + 1) << shift
+        overlaps = []
+        i = max(bisect.bisect_right(starts, low) - 1, 0)
+        while i < len(symbols) and symbols[i][0] < high:
+            start, end, name = symbols[i]
+            covered = min(end, high) - max(start, low)
+            if covered > 0:
+                overlaps.append((name, covered))
+            i += 1
+        total = sum(covered for _, covered in overlaps)
+        if total == 0:
+            overlaps, total = [("(no symbol)", 1)], 1
+        detail[bucket] = overlaps
+        for name, covered in overlaps:
+            shares[name] = shares.get(name, 0.0) + count * covered / total
+    return shares, detail
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="captured serial output, - for stdin")
+    parser.add_argument("elf", help="the ELF the dump was taken from")
+    parser.add_argument("--nm", default="avr-nm", help="nm for the ELF's target (default avr-nm, nm for host programs)")
+    parser.add_argument("--top", type=int, default=30, help="functions to list (default 30)")
+    parser.add_argument("--buckets", action="store_true", help="also list every bucket with the functions in it")
+    args = parser.parse_args()
+
+    stream = sys.stdin if args.dump == "-" else open(args.dump, errors="replace")
+    layout, counts = read_dump(stream)
+    symbols = read_symbols(args.nm, args.elf)
+    shares, detail = attribute(counts, symbols, layout["shift"])
+
+    inside = sum(counts.values())
+    samples = inside + layout["outside"]
+    print("%d samples at %d Hz, %.2f s of run time, %d bytes per bucket, %d above the covered range"
+          % (samples, layout["hz"], samples / float(layout["hz"]), 1 << layout["shift"], layout["outside"]))
+    if samples == 0:
+        return
+    print("\n%10s %7s  %s" % ("samples", "share", "function"))
+    for name, share in sorted(shares.items(), key=lambda item: -item[1])[:args.top]:
+        print("%10.1f %6.2f%%  %s" % (share, 100.0 * share / samples, name))
+
+    if args.buckets:
+        print("\n%-8s %8s  %s" % ("bucket", "samples", "functions, bytes in the bucket"))
+        for bucket in sorted(detail):
+            names = ", ".join("%s %d" % (name, covered) for name, covered in detail[bucket])
+            print("%06x   %8d  %s" % (bucket << layout["shift"], counts[bucket], names))
+
+
+if __name__ == "__main__":
+    main()
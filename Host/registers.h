@@ -0,0 +1,12 @@
+#ifndef HOST_REGISTERS_H_
+#define HOST_REGISTERS_H_
+
+/* ILI9341 commands used by the Elegoo_TFTLCD stand-in*/
+#define ILI9341_COLADDRSET          0x2A
+#define ILI9341_PAGEADDRSET         0x2B
+#define ILI9341_MEMORYWRITE         0x2C
+#define ILI9341_VERTSCROLLDEF       0x33
+#define ILI9341_MADCTL              0x36
+#define ILI9341_VERTSCROLLSTART     0x37
+
+#endif    // HOST_REGISTERS_H_
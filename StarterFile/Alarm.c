@@ -4,88 +4,156 @@
 #include "Arduino.h"
 
 /*****************************************************************
-  * Function name: updateHVoltInterlockAlrm
-  * Function inputs: byte* hVoltInterlock
+  * Function name: updateAlarmState
+  * Function inputs: byte* alarm, bool outside, float timeToLimit
   * Function outputs: void
-  * Function description: changes the HVInterlock pointer's value
-  *                       to cycle between [0, 1, 2] every second
+  * Function description: raises the alarm as active, not
+  *                       acknowledged, when its measurement leaves
+  *                       the limits. An active alarm keeps its
+  *                       acknowledgement, see acknowledgeAlarm,
+  *                       until the measurement is back inside, then
+  *                       it clears. Inside the
+  *                       limits the alarm is a pre-warning while
+  *                       the trend reaches a limit within
+  *                       PREWARN_SECONDS, until the time is back
+  *                       over PREWARN_CLEAR.
   * Author(s): Leonard Shin; Leika Yamada
   *****************************************************************/
-void updateHVoltInterlockAlarm ( byte* hVoltInterlock ) {
-    // 
-    // 
-    extern byte clockTick;
-    if( clockTick % 3 == 0 ){
-        *hVoltInterlock = NOT_ACTIVE;
+static void updateAlarmState ( byte* alarm, bool outside, float timeToLimit ) {
+
+    if( outside ){
+        if( *alarm == NOT_ACTIVE || *alarm == PRE_WARNING ){
+            *alarm = ACTIVE_NO_ACK;
+        }
+    }
+    else if( timeToLimit <= PREWARN_SECONDS ){
+        *alarm = PRE_WARNING;
     }
-    else if ( clockTick %3 == 1 ){
-        *hVoltInterlock = ACTIVE_NO_ACK;
+    else if( *alarm != PRE_WARNING || timeToLimit > PREWARN_CLEAR ){
+        *alarm = NOT_ACTIVE;
     }
-    else{
-        *hVoltInterlock = ACTIVE_ACK;
+}
+
+/*****************************************************************
+  * Function name: acknowledgeAlarm
+  * Function inputs: byte* alarm
+  * Function outputs: void
+  * Function description: an active alarm that was not acknowledged
+  *                       is acknowledged, any other state stays
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void acknowledgeAlarm ( byte* alarm ) {
+
+    if( *alarm == ACTIVE_NO_ACK ){
+        *alarm = ACTIVE_ACK;
     }
 }
 
+/*****************************************************************
+  * Function name: updateHVoltInterlockAlarm
+  * Function inputs: byte* hVoltInterlock, bool hvilStatus
+  * Function outputs: void
+  * Function description: the HVIL alarm is active while the
+  *                       interlock loop is open
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void updateHVoltInterlockAlarm ( byte* hVoltInterlock, bool hvilStatus ) {
+
+    updateAlarmState(hVoltInterlock, hvilStatus == HVIL_OPEN, TREND_NEVER);
+}
+
 /**********************************************************************
-  * Function name: updateHVoltInterlockAlrm
-  * Function inputs: byte* OverCurrent
+  * Function name: updateOverCurrent
+  * Function inputs: byte* overCurrent, float hvCurrent,
+  *                  float timeToLimit
   * Function outputs: void
-  * Function description: changes the OverCurrent's pointer's value
-  *                       to cycle between [0, 1, 2] every two seconds
+  * Function description: the over current alarm is active while the
+  *                       current is outside [CURRENT_MIN, CURRENT_MAX]
+  *                       and a pre-warning while its trend is heading
+  *                       out of them
   * Author(s): Leonard Shin; Leika Yamada
   *********************************************************************/
-void updateOverCurrent ( byte* overCurrent ) {
+void updateOverCurrent ( byte* overCurrent, float hvCurrent, float timeToLimit ) {
 
-    extern byte clockTick;
-    if( clockTick/2 % 3 == 0 ){
-        *overCurrent = NOT_ACTIVE;
-    }
-    else if ( clockTick/2 %3 == 1 ){
-        *overCurrent = ACTIVE_NO_ACK;
-    }
-    else{
-        *overCurrent = ACTIVE_ACK;
-    }
+    updateAlarmState(overCurrent, hvCurrent < CURRENT_MIN || hvCurrent > CURRENT_MAX, timeToLimit);
 }
 
 /************************************************************************
   * Function name: updateHVoltOutofRange
-  * Function inputs: byte* HVoltOutofRange
+  * Function inputs: byte* hVoltOutofRange, float hvVoltage,
+  *                  float timeToLimit
   * Function outputs: void
-  * Function description: Changes the HVoltOutofRange pointer's value
-  *                       to cycle between [0, 1, 2] every three seconds
+  * Function description: the HV out of range alarm is active while
+  *                       the voltage is outside [VOLTAGE_MIN,
+  *                       VOLTAGE_MAX] and a pre-warning while its
+  *                       trend is heading out of them
   * Author(s): Leonard Shin; Leika Yamada
   **********************************************************************/
-void updateHVoltOutofRange ( byte* hVoltOutofRange ) {
-    
-    extern byte clockTick;
-    if( clockTick/3 % 3 == 0 ){
-        *hVoltOutofRange = NOT_ACTIVE;
-    }
-    else if ( clockTick/3 %3 == 1 ){
-        *hVoltOutofRange = ACTIVE_NO_ACK;
-    }
-    else{
-        *hVoltOutofRange = ACTIVE_ACK;
+void updateHVoltOutofRange ( byte* hVoltOutofRange, float hvVoltage, float timeToLimit ) {
+
+    updateAlarmState(hVoltOutofRange, hvVoltage < VOLTAGE_MIN || hvVoltage > VOLTAGE_MAX, timeToLimit);
+}
+
+/*****************************************************************
+  * Function name: traceAlarm
+  * Function inputs: alarmData* data, byte before, byte after,
+  *                  byte channel, unsigned long now
+  * Function outputs: void
+  * Function description: records how old the channel's sample was
+  *                       when the alarm was evaluated, and stamps
+  *                       the alarm change time if its state moved
+  * Author(s): Leonard Shin; Leika Yamada
+  ****************************************************************/
+static void traceAlarm ( alarmData* data, byte before, byte after, byte channel, unsigned long now ) {
+
+    recordLatency(&data->latency->sampleToAlarm, data->channels->channel[channel].lastSample, now);
+    if( before != after ){
+        *data->alarmStamp = now;
     }
 }
 
 /*****************************************************************
-  * Function name: measurementTask
+  * Function name: alarmTask
   * Function inputs: void* mData
   * Function outputs: void
   * Function description: Modifies mData to represent
-  *                       the Alarm data at the current time point
+  *                       the Alarm data at the current time point,
+  *                       from the pack's latest measurements and
+  *                       the trends of current and voltage. A
+  *                       pending acknowledgement from the alarm
+  *                       screen applies to the alarms active before
+  *                       this update.
   * Author(s): Leonard Shin; Leika Yamada
   ****************************************************************/
 void alarmTask ( void* mData ) {
     
     alarmData* data = (alarmData*) mData;
+    byte hVoltInterlock  = *data->hVoltInterlock;
+    byte overCurrent     = *data->overCurrent;
+    byte hVoltOutofRange = *data->hVoltOutofRange;
     
+    /* Project the trends to the limits */
+    *data->currentTimeToLimit = statsTimeToLimit(data->currentStats, CURRENT_MIN, CURRENT_MAX);
+    *data->voltageTimeToLimit = statsTimeToLimit(data->voltageStats, VOLTAGE_MIN, VOLTAGE_MAX);
+
+    /* Acknowledge what the user saw */
+    if( *data->acknowledge ){
+        acknowledgeAlarm(data->hVoltInterlock);
+        acknowledgeAlarm(data->overCurrent);
+        acknowledgeAlarm(data->hVoltOutofRange);
+        *data->acknowledge = false;
+    }
+
     /* Update all sensors */
-    updateHVoltInterlockAlarm(data->hVoltInterlock);
-    updateOverCurrent(data->overCurrent);
-    updateHVoltOutofRange(data->hVoltOutofRange);
+    updateHVoltInterlockAlarm(data->hVoltInterlock, *data->hvilStatus);
+    updateOverCurrent(data->overCurrent, *data->hvCurrent, *data->currentTimeToLimit);
+    updateHVoltOutofRange(data->hVoltOutofRange, *data->hvVoltage, *data->voltageTimeToLimit);
+
+    /* Trace the age of the samples behind each alarm */
+    unsigned long now = micros();
+    traceAlarm(data, hVoltInterlock, *data->hVoltInterlock, CHANNEL_HVIL, now);
+    traceAlarm(data, overCurrent, *data->overCurrent, CHANNEL_CURRENT, now);
+    traceAlarm(data, hVoltOutofRange, *data->hVoltOutofRange, CHANNEL_VOLTAGE, now);
     
     return;
 }
@@ -8,17 +8,44 @@ extern "C" {
 #include <stdlib.h>
 #include <stdbool.h>
 #include <Arduino.h>
+#include "Measurement.h"
+#include "Latency.h"
 
 
 #define NOT_ACTIVE      0
 #define ACTIVE_NO_ACK   1
 #define ACTIVE_ACK      2
+#define PRE_WARNING     3           // Inside the limits, but the trend reaches one within PREWARN_SECONDS
+
+/* Alarm limits, an alarm is active while its measurement is outside them*/
+#define CURRENT_MIN     -5.0        // Amps, charging current limit
+#define CURRENT_MAX     25.0        // Amps, discharging current limit
+#define VOLTAGE_MIN     280.0       // Volts
+#define VOLTAGE_MAX     405.0       // Volts
+
+/* Pre-warning of the current and voltage alarms, from the time their trend
+ * takes to reach a limit. It clears once the time is back over
+ * PREWARN_CLEAR, so a trend hovering near PREWARN_SECONDS does not flicker.*/
+#define PREWARN_SECONDS 10.0
+#define PREWARN_CLEAR   15.0
 
 
 typedef struct alarmTaskData {
     byte* hVoltInterlock;           // Store HVIL Status, over current, HV out of range
     byte* overCurrent;              // 0 for alarm not active, 1, for active not acknowledged          
     byte* hVoltOutofRange;          // and 2 for active acknowledged
+    const bool* hvilStatus;         // Measurements the alarms are evaluated on
+    const float* hvCurrent;
+    const float* hvVoltage;
+    channelTable* channels;         // Sample timestamps of the channels the alarms are based on
+    unsigned long* alarmStamp;      // micros() when any alarm last changed state
+    latencyTrace* latency;          // Sample to alarm ages are recorded here
+    const channelStats* currentStats;   // Trends the pre-warnings are based on
+    const channelStats* voltageStats;
+    float* currentTimeToLimit;      // Seconds until the trend crosses a limit, TREND_NEVER
+    float* voltageTimeToLimit;      //  if it is not heading for one
+    bool* acknowledge;              // Set by the alarm screen's ACK button, active alarms are acknowledged
+                                    //  and it is cleared on the next run
 } alarmData;
 
 
@@ -0,0 +1,239 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "Capture.h"
+#include "Alarm.h"
+#include "Arduino.h"
+
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#endif
+
+/*****************************************************************
+  * Function name: initCapture
+  * Function inputs: captureBuffer* buffer,
+  *                  const captureStorage* storage
+  * Function outputs: void
+  * Function description: empties the ring and arms it, captures
+  *                       will go to storage
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void initCapture ( captureBuffer* buffer, const captureStorage* storage ) {
+
+    buffer->head      = 0;
+    buffer->filled    = 0;
+    buffer->remaining = 0;
+    buffer->state     = CAPTURE_ARMED;
+    buffer->outside   = 0;
+    buffer->stored    = 0;
+    buffer->captures  = 0;
+    buffer->missed    = 0;
+    buffer->storage   = storage;
+}
+
+/*****************************************************************
+  * Function name: freezeCapture
+  * Function inputs: captureBuffer* buffer
+  * Function outputs: void
+  * Function description: stops the ring once the post trigger
+  *                       samples are in and completes the header
+  *                       for storage
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void freezeCapture ( captureBuffer* buffer ) {
+
+    buffer->header.magic   = CAPTURE_MAGIC;
+    buffer->header.version = CAPTURE_VERSION;
+    buffer->header.samples = buffer->header.pre + CAPTURE_POST;
+    buffer->header.missed  = buffer->missed;
+    buffer->first  = (byte) ( buffer->head - buffer->header.samples ) % CAPTURE_SAMPLES;
+    buffer->stored = 0;
+    buffer->state  = CAPTURE_FROZEN;
+}
+
+/*****************************************************************
+  * Function name: recordCapture
+  * Function inputs: captureBuffer* buffer, unsigned long stamp,
+  *                  float current, float voltage, bool hvil
+  * Function outputs: void
+  * Function description: writes one sample into the ring and
+  *                       triggers a capture when the current has
+  *                       just left [CURRENT_MIN, CURRENT_MAX] or the
+  *                       interlock has just opened. While armed
+  *                       the sample is the only store to the ring.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void recordCapture ( captureBuffer* buffer, unsigned long stamp, float current, float voltage, bool hvil ) {
+
+    byte outside = ( current < CURRENT_MIN || current > CURRENT_MAX ) ? CAPTURE_OVER_CURRENT : 0;
+    byte trigger;
+
+    if( hvil == HVIL_OPEN ){
+        outside |= CAPTURE_HVIL_OPEN;
+    }
+    trigger = outside & ~buffer->outside;
+    buffer->outside = outside;
+
+    if( buffer->state >= CAPTURE_FROZEN ){                          // Ring is waiting for storage, keep it as it is
+        if( trigger ){
+            buffer->missed++;
+        }
+        return;
+    }
+
+    buffer->ring[buffer->head % CAPTURE_SAMPLES] = (captureSample) {
+        (uint32_t) ( ( stamp & ~1UL ) | hvil ), (int16_t) ( current * CAPTURE_CURRENT_SCALE ), (uint16_t) ( voltage * CAPTURE_VOLTAGE_SCALE )
+    };
+    buffer->head++;
+
+    if( buffer->state == CAPTURE_ARMED ){
+        if( buffer->filled < CAPTURE_PRE ){
+            buffer->filled++;
+        }
+        if( trigger ){
+            buffer->header.cause   = trigger;
+            buffer->header.pre     = buffer->filled;
+            buffer->header.trigger = stamp & ~1UL;
+            buffer->remaining = CAPTURE_POST;
+            buffer->state     = CAPTURE_TRIGGERED;
+        }
+    }
+    else if( --buffer->remaining == 0 ){
+        freezeCapture(buffer);
+    }
+}
+
+/*****************************************************************
+  * Function name: captureTask
+  * Function inputs: void* cData, the captureBuffer
+  * Function outputs: void
+  * Function description: copies a frozen capture to storage, header
+  *                       first, as many bytes per call as storage
+  *                       takes without blocking and at most
+  *                       CAPTURE_CHUNK, then polls storage until it
+  *                       has finished. Once it is all stored, or
+  *                       storage has no room for it and it counts as
+  *                       missed, the ring is armed again. Costs one
+  *                       compare while armed.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void captureTask ( void* cData ) {
+
+    captureBuffer* buffer = (captureBuffer*) cData;
+    unsigned int total;
+    const byte* from;
+    unsigned int length;
+
+    if( buffer->state < CAPTURE_FROZEN ){
+        return;
+    }
+    total = sizeof(captureHeader) + buffer->header.samples * sizeof(captureSample);
+
+    if( buffer->state == CAPTURE_FROZEN ){
+        if( !buffer->storage->begin(total) ){                       // Nowhere to put it, give the ring back
+            buffer->missed++;
+            buffer->filled = 0;
+            buffer->state  = CAPTURE_ARMED;
+            return;
+        }
+        buffer->state = CAPTURE_STORING;
+    }
+
+    if( buffer->stored == total ){                                  // All written, waiting for storage to finish
+        if( buffer->storage->end() ){
+            buffer->captures++;
+            buffer->filled = 0;
+            buffer->state  = CAPTURE_ARMED;
+        }
+        return;
+    }
+
+    if( buffer->stored < sizeof(captureHeader) ){
+        from   = (const byte*) &buffer->header + buffer->stored;
+        length = sizeof(captureHeader) - buffer->stored;
+    }
+    else {                                                          // The samples may wrap around the end of the ring
+        unsigned int at = buffer->stored - sizeof(captureHeader);
+        byte slot = ( buffer->first + at / sizeof(captureSample) ) % CAPTURE_SAMPLES;
+        from   = (const byte*) &buffer->ring[slot] + at % sizeof(captureSample);
+        length = ( CAPTURE_SAMPLES - slot ) * sizeof(captureSample) - at % sizeof(captureSample);
+        if( length > total - buffer->stored ){
+            length = total - buffer->stored;
+        }
+    }
+    if( length > CAPTURE_CHUNK ){
+        length = CAPTURE_CHUNK;
+    }
+    buffer->stored += buffer->storage->write(from, length);
+}
+
+#if defined(__AVR__)
+
+/* The Mega's 4 KB EEPROM holds one capture from address 0. A byte takes
+ * 3.3 ms to program and wears out after about 100000 writes, so the slot
+ * keeps the first capture until captureMonitor() in the sketch reads it
+ * out and clears it; triggers meanwhile only count as missed and the
+ * EEPROM is not written at all. Storing takes a few seconds, one byte per
+ * scheduler pass that finds the EEPROM ready. The magic byte at address
+ * 0 goes in last, so a capture cut short by a reset is not taken for a
+ * stored one.*/
+static unsigned int eepromAddress;
+
+static bool eepromBegin ( unsigned int length ) {
+
+    if( eepromCaptureHeld() || length > E2END + 1 ){
+        return false;
+    }
+    eepromAddress = 0;
+    return true;
+}
+
+static unsigned int eepromWrite ( const byte* data, unsigned int length ) {
+
+    if( length == 0 || !eeprom_is_ready() ){
+        return 0;
+    }
+    if( eepromAddress > 0 ){                                        // Starts the write and returns, the EEPROM was ready
+        eeprom_update_byte((uint8_t*) eepromAddress, data[0]);
+    }
+    eepromAddress++;
+    return 1;
+}
+
+static bool eepromEnd ( void ) {
+
+    if( !eeprom_is_ready() ){
+        return false;
+    }
+    eeprom_update_byte((uint8_t*) 0, CAPTURE_MAGIC);
+    return true;
+}
+
+const captureStorage eepromStorage = { eepromBegin, eepromWrite, eepromEnd };
+
+/*****************************************************************
+  * Function name: eepromCaptureHeld, eepromCaptureByte,
+  *                eepromCaptureClear
+  * Function inputs: unsigned int at, the byte's offset from the
+  *                  start of the capture
+  * Function outputs: whether a capture is held, the byte
+  * Function description: read out of the capture the EEPROM holds,
+  *                       and clearing it so the next trip is stored.
+  *                       Clearing writes one byte.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+bool eepromCaptureHeld ( void ) {
+
+    return eeprom_read_byte((const uint8_t*) 0) == CAPTURE_MAGIC;
+}
+
+byte eepromCaptureByte ( unsigned int at ) {
+
+    return eeprom_read_byte((const uint8_t*) at);
+}
+
+void eepromCaptureClear ( void ) {
+
+    eeprom_update_byte((uint8_t*) 0, (byte) ~CAPTURE_MAGIC);
+}
+
+#endif
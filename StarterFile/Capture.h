@@ -0,0 +1,105 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+
+/* Burst capture of current, voltage and HVIL around an over current or
+ * interlock trip. Every current sample, with the latest voltage and HVIL
+ * input, is written into a ring of CAPTURE_SAMPLES records; that one store
+ * and the trigger compares are all the capture costs while nothing happens.
+ * The sample rate is the current channel's, which runs at its fastest near
+ * a limit. When the current leaves its alarm limits or the interlock opens,
+ * the ring keeps the CAPTURE_PRE samples up to the trigger, takes
+ * CAPTURE_POST more and freezes. captureTask() then hands it to storage a
+ * few bytes per scheduler pass and arms the ring again; triggers while a
+ * capture waits to be stored, and captures storage has no room for, are
+ * counted in missed.*/
+#define CAPTURE_SAMPLES         128                 // Power of two, the ring index is a byte
+#define CAPTURE_PRE             64                  // Samples kept up to and including the trigger
+#define CAPTURE_POST            ( CAPTURE_SAMPLES - CAPTURE_PRE )
+#define CAPTURE_CHUNK           16                  // Most bytes offered to storage per pass
+#define CAPTURE_CURRENT_SCALE   100.0               // Counts per amp, +-327 A
+#define CAPTURE_VOLTAGE_SCALE   100.0               // Counts per volt, 0 - 655 V
+
+/* A stored capture is a captureHeader, then header.samples captureSamples
+ * oldest first, both as they are in RAM: little endian and laid out the
+ * same on the AVR and the host.*/
+#define CAPTURE_MAGIC           0xCA
+#define CAPTURE_VERSION         1
+
+/* Trigger causes, bits so both can be recorded at once*/
+#define CAPTURE_OVER_CURRENT    0x01
+#define CAPTURE_HVIL_OPEN       0x02
+
+/* Capture states*/
+#define CAPTURE_ARMED           0                   // Ring running, waiting for a trigger
+#define CAPTURE_TRIGGERED       1                   // Taking the post trigger samples
+#define CAPTURE_FROZEN          2                   // Complete, not yet started on storage
+#define CAPTURE_STORING         3                   // Being copied to storage
+
+
+typedef struct captureSampleData {
+    uint32_t stamp;                     // micros(), bit 0 holds the HVIL input; the AVR's micros() counts in 4 us steps
+    int16_t current;                    // CAPTURE_CURRENT_SCALE counts per amp
+    uint16_t voltage;                   // CAPTURE_VOLTAGE_SCALE counts per volt
+} captureSample;
+
+typedef struct captureHeaderData {
+    byte magic;
+    byte version;
+    byte cause;                         // CAPTURE_OVER_CURRENT and/or CAPTURE_HVIL_OPEN
+    byte pre;                           // Samples up to and including the trigger, CAPTURE_PRE unless
+                                        //  the trigger came soon after the ring was armed
+    uint16_t samples;                   // Samples after the header
+    uint16_t missed;                    // Triggers lost since start up, see captureBuffer
+    uint32_t trigger;                   // Stamp of the trigger sample
+} captureHeader;
+
+typedef struct captureStorageData {     // Where frozen captures go: EEPROM, SPI flash, an SD card, a file on the host
+    bool (*begin)(unsigned int length);                         // A capture of length bytes follows, false if there is no room
+    unsigned int (*write)(const byte* data, unsigned int length);   // Takes up to length bytes without blocking, returns how many
+    bool (*end)(void);                                          // The capture is complete, false until storage
+                                                                //  has finished with it, called again next pass
+} captureStorage;
+
+typedef struct captureBufferData {
+    captureSample ring[CAPTURE_SAMPLES];
+    byte head;                          // Slot the next sample goes in, modulo CAPTURE_SAMPLES
+    byte filled;                        // Samples since the ring was armed, up to CAPTURE_PRE
+    byte remaining;                     // Post trigger samples still to take
+    byte state;                         // CAPTURE_*
+    byte outside;                       // Trigger causes true at the previous sample, a trigger is a new one
+    byte first;                         // Slot of the oldest sample of the frozen capture
+    captureHeader header;               // Of the frozen capture
+    unsigned int stored;                // Bytes of the frozen capture storage has taken
+    unsigned int captures;              // Captures stored since start up
+    unsigned int missed;                // Triggers while a capture waited for storage or storage was full
+    const captureStorage* storage;
+} captureBuffer;
+
+
+extern const captureStorage eepromStorage;      // AVR EEPROM, one capture from address 0, kept until cleared
+
+bool eepromCaptureHeld (void);                  // The EEPROM holds a capture, later ones are missed
+byte eepromCaptureByte (unsigned int at);       // Byte at of the held capture, header first
+void eepromCaptureClear (void);                 // Frees the EEPROM for the next capture
+
+void initCapture (captureBuffer* buffer, const captureStorage* storage);
+void recordCapture (captureBuffer* buffer, unsigned long stamp, float current, float voltage, bool hvil);   // One sample
+void captureTask (void*);                       // Non blocking, call every scheduler pass with the captureBuffer
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,28 +2,31 @@
 #include <stdbool.h>
 #include <Arduino.h>
 #include "Contactor.h"
+#include "Gpio.h"
 
 /******************************************************************
   * Function name: updateContactor
-  * Function inputs: bool* contactorStatus, int* contactorLED
+  * Function inputs: bool* contactorStatus, bool* local, bool* ack,
+  *                  unsigned long* commandStamp,
+  *                  latencyHistogram* commandToPin
   * Function outputs: void
   * Function description: updates the conctactor LED's value
   *                       based upon the contactor status (changes
-  *                       the contactor signal into an output)
+  *                       the contactor signal into an output) and
+  *                       records how long a change took to reach
+  *                       the pin. The pin is only written when the
+  *                       status changed; setup() drives it to match
+  *                       the starting status.
   * Author(s): Leonard Shin, Leika Yamada
   *****************************************************************/
-void updateContactor ( bool* contactorStatus, bool* local, bool* ack, int* contactorLED ) {
+void updateContactor ( bool* contactorStatus, bool* local, bool* ack,
+                       unsigned long* commandStamp, latencyHistogram* commandToPin ) {
         // Need to ack change if it was changed
     if(*contactorStatus != *local){
         *local = *contactorStatus;
         *ack = true; 
-    }
-    if( *contactorStatus == 0 ){
-        
-        digitalWrite(*contactorLED, LOW);
-    }
-    else{
-        digitalWrite(*contactorLED, HIGH);
+        gpioPin<CONTACTOR_PIN>::write(*contactorStatus);
+        recordLatency(commandToPin, *commandStamp, micros());
     }
       
     return;
@@ -40,7 +43,8 @@ void contactorTask ( void* contactData ) {
   
     contactorData* data = (contactorData*) contactData;
     
-    updateContactor(data->contactorStatus, data->localContactor, data->acknowledge, data->contactorLED);   // Update all sensors
+    updateContactor(data->contactorStatus, data->localContactor, data->acknowledge,    // Update all sensors
+                    data->commandStamp, &data->latency->commandToPin);
     
     return;
 }
@@ -9,6 +9,10 @@ extern "C" {
 #include <stdlib.h>
 #include <stdbool.h>
 #include <Arduino.h>
+#include "Latency.h"
+
+
+#define CONTACTOR_PIN   53          // Contactor output, written through gpioPin<CONTACTOR_PIN>
 
 
 typedef struct contactorTaskData {  // Structure that holds contactor data
@@ -16,7 +20,8 @@ typedef struct contactorTaskData {  // Structure that holds contactor data
     bool* localContactor;          // holds a local version of the contactor that no other task modifies to check if the contactor Status was update
     bool* acknowledge;              // if it was acknowledged it should flip the acknowledge flag to true, which will then be turned off by the display when
                                     //  it notices that the acknowledge flag is true;
-    int* contactorLED;              // Output pin number
+    unsigned long* commandStamp;    // micros() when contactorStatus was last changed by its owner
+    latencyTrace* latency;          // Command to pin ages are recorded here
 } contactorData;
 
 
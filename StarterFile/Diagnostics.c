@@ -0,0 +1,153 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "Diagnostics.h"
+#include "Arduino.h"
+
+#if defined(__AVR__)
+extern char __heap_start;
+extern char* __brkval;
+
+/*****************************************************************
+  * Function name: paintStack
+  * Function inputs: void
+  * Function outputs: void
+  * Function description: fills the RAM from the end of the static
+  *                       data up to the top of the stack with
+  *                       STACK_CANARY. Runs from .init1, before the
+  *                       stack pointer and r1 are set up, so it is
+  *                       assembly that uses neither.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void paintStack (void) __attribute__((naked, used, section(".init1")));
+
+void paintStack ( void ) {
+
+    __asm__ volatile (
+        "    ldi r30, lo8(_end)      \n"
+        "    ldi r31, hi8(_end)      \n"
+        "    ldi r24, %0             \n"
+        "    ldi r25, hi8(__stack)   \n"
+        "    rjmp 2f                 \n"
+        "1:  st Z+, r24              \n"
+        "2:  cpi r30, lo8(__stack)   \n"
+        "    cpc r31, r25            \n"
+        "    brlo 1b                 \n"
+        "    breq 1b                 \n"
+        :
+        : "i" (STACK_CANARY)
+    );
+}
+
+static byte* lowWater = NULL;       // Lowest stack byte known to have been used
+#endif
+
+/*****************************************************************
+  * Function name: runTask
+  * Function inputs: TCB* tcb, unsigned long release,
+  *                  unsigned long start
+  * Function outputs: unsigned long, micros() when the task ended
+  * Function description: runs one call of the task and accounts
+  *                       for it. release is when the task became
+  *                       due, start when it was called; passing
+  *                       the end of the previous task as start
+  *                       saves a clock read per task.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+unsigned long runTask ( TCB* tcb, unsigned long release, unsigned long start ) {
+
+    taskStats* stats = &tcb->stats;
+    unsigned long end, run;
+
+    tcb->task(tcb->taskDataPtr);
+    end = micros();
+    run = end - start;
+    if( run > 0xFFFF ){
+        run = 0xFFFF;
+    }
+
+    if( stats->fastest == 0 || run < stats->fastest ){      // 0 before the first run
+        stats->fastest = run ? run : 1;
+    }
+    stats->runs++;
+    stats->time += run;
+    stats->work += tcb->polled ? run - ( stats->fastest < run ? stats->fastest : run ) : run;
+    if( run > stats->longest ){
+        stats->longest = run;
+    }
+    if( end - release > tcb->deadline ){
+        stats->misses++;
+    }
+    return end;
+}
+
+/*****************************************************************
+  * Function name: closeTaskWindows
+  * Function inputs: TCB** tasks, byte count, schedulerStats* stats,
+  *                  unsigned long now
+  * Function outputs: void
+  * Function description: ends the current window of every task and
+  *                       of the scheduler. The idle share is the
+  *                       time no task spent on work: the polling
+  *                       cost of tasks with nothing to do and the
+  *                       scheduler's own loop count as idle.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void closeTaskWindows ( TCB** tasks, byte count, schedulerStats* stats, unsigned long now ) {
+
+    unsigned long elapsed = now - stats->windowStart;
+    unsigned long work = 0;
+
+    for( byte i = 0; i < count; i++ ){
+        taskStats* task = &tasks[i]->stats;
+        task->average = task->runs ? task->time / task->runs : 0;
+        task->worst   = task->longest;
+        work += task->work;
+        task->runs    = 0;
+        task->time    = 0;
+        task->work    = 0;
+        task->longest = 0;
+    }
+
+    stats->idle = ( elapsed > work ) ? 100 - work / ( elapsed / 100 + 1 ) : 0;
+    stats->windowStart = now;
+}
+
+/*****************************************************************
+  * Function name: stackHeadroom
+  * Function inputs: void
+  * Function outputs: unsigned int, bytes
+  * Function description: free RAM below the deepest point the stack
+  *                       has reached. The scan carries on down from
+  *                       the deepest point found last time and stops
+  *                       at STACK_CANARY_RUN painted bytes in a row,
+  *                       so a call costs about the new depth, not
+  *                       the whole free RAM. STACK_UNKNOWN on the
+  *                       host.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+unsigned int stackHeadroom ( void ) {
+
+#if defined(__AVR__)
+    byte* bottom = (byte*) ( __brkval ? __brkval : &__heap_start );
+    byte* at;
+    byte run = 0;
+
+    if( lowWater == NULL ){
+        lowWater = (byte*) SP;
+    }
+    at = lowWater;
+    while( at > bottom && run < STACK_CANARY_RUN ){
+        at--;
+        if( *at == STACK_CANARY ){
+            run++;
+        }
+        else {
+            run = 0;
+            lowWater = at;
+        }
+    }
+    return ( lowWater > bottom ) ? lowWater - bottom : 0;
+#else
+    return STACK_UNKNOWN;
+#endif
+}
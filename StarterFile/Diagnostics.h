@@ -0,0 +1,45 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DIAGNOSTICS_H_
+#define DIAGNOSTICS_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <Arduino.h>
+#include "TaskControlBlock.h"
+#include "Measurement.h"
+
+
+/* Scheduler diagnostics behind the diagnostics screen. The scheduler runs
+ * every task through runTask(), which times it with the micros() reading
+ * the previous task ended on, so one clock read per task is all the
+ * accounting costs. Once a second closeTaskWindows() turns the counts into
+ * per task averages and the CPU idle share.*/
+#define PASS_DEADLINE       CURRENT_MIN_PERIOD  // Tasks polled every pass must all finish before the fastest channel is due again
+#define TASK_DEADLINE       20000UL             // Once a second tasks and display slices, from their release
+#define TASK_COUNT          8                   // Tasks the scheduler runs, see allTasks in the sketch
+
+#define STACK_CANARY        0xC5                // Free RAM is painted with this at reset
+#define STACK_CANARY_RUN    8                   // Untouched bytes in a row that end the stack scan
+#define STACK_UNKNOWN       0xFFFF              // stackHeadroom() where the stack is not painted
+
+
+typedef struct schedulerStatsData {
+    unsigned long windowStart;      // micros() the current window started
+    byte idle;                      // Percent of the last complete window the CPU had no work
+} schedulerStats;
+
+
+unsigned long runTask (TCB* tcb, unsigned long release, unsigned long start);  // Runs one slice, returns micros() when it ended
+void closeTaskWindows (TCB** tasks, byte count, schedulerStats* stats, unsigned long now);
+unsigned int stackHeadroom (void);                      // Bytes between the deepest stack use so far and the heap
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,6 +7,7 @@
 #include <registers.h>
 #include <TouchScreen.h>
 #include "Display.h" 
+#include "Gpio.h"
 
 
 /*Global Varibles to update the display screen*/
@@ -17,26 +18,42 @@ extern byte currentScreen;
 extern bool measureButton;
 extern bool alarmButton;
 extern bool batteryButton;
+extern bool trendButton;
+extern bool diagnosticsButton;
 
-extern Elegoo_GFX_Button buttons[3];
-extern char buttonlabels[3][9];
-extern uint16_t buttoncolors[3];
+extern Elegoo_GFX_Button buttons[SCREEN_BUTTONS];
+extern char buttonlabels[SCREEN_BUTTONS][9];
+extern uint16_t buttoncolors[SCREEN_BUTTONS];
 extern Elegoo_GFX_Button batteryButtons[2];
 extern char batteryButtonLabels[2][4];
+extern Elegoo_GFX_Button alarmAckButton;
+extern char alarmAckLabel[4];
 
 /*Measurement, Alarm, HVIL, and Contactor data*/
 extern float hvCurrent;
 extern float hvVoltage;
 extern float temperature;
 extern bool hVIL;
-extern const byte hvilPin;
 extern byte hVoltInterlock;
 extern byte overCurrent;
 extern byte hVoltOutofRange;
 extern float stateOfCharge;
 extern bool contactorState;
-extern int contactorLED;
 extern bool contactorAck;
+extern trendHistory history;
+extern uint16_t lcdIdentifier;
+extern channelTable channels;
+extern latencyTrace latency;
+extern unsigned long alarmStamp;
+extern float currentTimeToLimit;
+extern float voltageTimeToLimit;
+extern unsigned long contactorStamp;
+extern bool alarmAcknowledge;
+
+/*Scheduler and queue data*/
+extern TCB* allTasks[TASK_COUNT];
+extern schedulerStats scheduler;
+extern telemetryQueue telemetryFrames;
 
 /*Local Copies of global data to keep track of updated values*/
 /*Measurement Data*/
@@ -50,6 +67,8 @@ const byte localHvilPin  = 22;
 byte localHVoltInterlock = 0;
 byte localOverCurrent = 0;
 byte localHVoltOutofRange = 0;
+unsigned int localCurrentLimit = LIMIT_NONE;        // Whole seconds on the screen, LIMIT_NONE for --
+unsigned int localVoltageLimit = LIMIT_NONE;
 
 /*State Of Charge Data*/
 float localStateOfCharge = 1;
@@ -58,6 +77,55 @@ float localStateOfCharge = 1;
 bool localContactorState = 0;
 int localContactorLED = 53;
 
+/*Trend Data*/
+unsigned long localHistoryTotal = 0;                // history.total at the last plotted sample
+byte trendLine = 0;                                 // Plot line the next sample is drawn on, 0 is the bottom line
+
+/*Redraw slices. Protothreads lose their local variables when they yield,
+ *so their state is kept here.*/
+pt screenThread;                                    // Screen that is being drawn after a button press
+pt clearThread;                                     // Background clear shared by all screens
+byte clearBand = 0;                                 // Next band of the background to clear
+
+/*Diagnostics Data. Every value on the screen is a field: average, worst
+ *and misses of each task, then the scheduler and queue rows.*/
+#define DIAG_TASK_FIELDS ( TASK_COUNT * 3 )
+#define DIAG_IDLE        ( DIAG_TASK_FIELDS )
+#define DIAG_STACK       ( DIAG_TASK_FIELDS + 1 )
+#define DIAG_QUEUED      ( DIAG_TASK_FIELDS + 2 )
+#define DIAG_DEEPEST     ( DIAG_TASK_FIELDS + 3 )
+#define DIAG_DROPPED     ( DIAG_TASK_FIELDS + 4 )
+#define DIAG_FIELDS      ( DIAG_TASK_FIELDS + 5 )
+
+const char* const diagnosticsLabels[DIAG_FIELDS - DIAG_TASK_FIELDS] = {
+    "CPU idle", "Stack free", "Telemetry queued", "Telemetry deepest", "Telemetry dropped"
+};
+unsigned int diagnosticsValues[DIAG_FIELDS];        // Snapshot the screen is being brought up to
+unsigned int localDiagnostics[DIAG_FIELDS];         // Values on the screen
+bool diagnosticsBlank = false;                      // Screen just drawn, no values on it yet
+byte diagnosticsField = 0;                          // Next field the update compares
+
+
+/*********************************************************************************
+    * Function name: clearScreen
+    * Function inputs: pt* p
+    * Function outputs: char, PT_YIELDED until the whole background is cleared
+    * Function description: Clears the 240x200 area above the buttons one band per
+    *                       call, so a screen change never blocks for a full fill.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+PT_THREAD(clearScreen ( pt* p )) {
+
+    PT_BEGIN(p);
+
+    for ( clearBand = 0; clearBand < CLEAR_BANDS; clearBand++ ) {
+        tft.fillRect(0, clearBand * CLEAR_BAND_H, 240, CLEAR_BAND_H, BLACK);
+        PT_YIELD(p);
+    }
+
+    PT_END(p);
+}
+
 
 /*********************************************************************************
     * Function name: batteryButtonDisplay 
@@ -81,24 +149,46 @@ void batteryButtonDisplay (){
   }
 
 /*********************************************************************************
-    * Function name: displayMeasurementScreen
+    * Function name: alarmButtonDisplay
     * Function inputs: void
     * Function outputs: void
-    * Function description: Draws the measurement labels on the measurement screen. 
+    * Function description: Draws the ACK button for the alarm screen.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void alarmButtonDisplay (){
+
+    alarmAckButton.initButton(&tft, ACK_BUTTON_X, ACK_BUTTON_Y,                       // Takes input: X,Y,Width,Height,Outline Color, Color, TextColor,
+        BUTTON_W, BUTTON_H, WHITE, YELLOW, BLACK,                                     // label, and size
+        alarmAckLabel, BUTTON_TEXTSIZE);
+
+    alarmAckButton.drawButton();
+
+    return;
+}
+
+/*********************************************************************************
+    * Function name: displayMeasurementScreen
+    * Function inputs: pt* p
+    * Function outputs: char, PT_YIELDED until the screen is drawn
+    * Function description: Draws the measurement labels on the measurement screen,
+    *                       a slice per call. 
     * Author(s): Leonard Shin, Leika Yamada
     ******************************************************************************/  
-void displayMeasurementScreen (){
+PT_THREAD(displayMeasurementScreen ( pt* p )){
   
+    PT_BEGIN(p);
     currentScreen = MEASURE;                      // Set the current screen to measurement screen
     
-    tft.fillRect(0, 0, 240, 200, BLACK);          // Set background to black
+    PT_SPAWN(p, &clearThread, clearScreen(&clearThread));   // Set background to black
     tft.setCursor(50, 0);  
                                                                                        
     tft.setTextColor(CYAN); 
     tft.setTextSize(2);
                                                               
     tft.print("Measurements"); 
+    PT_YIELD(p);
     
+    tft.setTextColor(CYAN); 
     tft.setTextSize(1.5);
     tft.setCursor(0, 40);
     tft.print("State of Charge: "); 
@@ -115,31 +205,36 @@ void displayMeasurementScreen (){
     tft.setCursor(0, 120);
     tft.print("HVIL Status: ");
     tft.setCursor(160, 120);
-    if( hVIL ){                              // Check if the dip switch is open or closed and print status
+    if( hVIL == HVIL_OPEN ){                         // Check if the dip switch is open or closed and print status
         tft.print("OPEN");
     }else{
         tft.print("CLOSED");
     }
     
-    return; 
+    PT_END(p); 
 }
 
 /*********************************************************************************
     * Function name: displayAlarmScreen
-    * Function inputs: void
-    * Function outputs: void
-    * Function description: Draws the alarm labels on the alarm screen. 
+    * Function inputs: pt* p
+    * Function outputs: char, PT_YIELDED until the screen is drawn
+    * Function description: Draws the alarm labels on the alarm screen, a slice
+    *                       per call. 
     * Author(s): Leonard Shin, Leika Yamada
     ******************************************************************************/
-void displayAlarmScreen (){
+PT_THREAD(displayAlarmScreen ( pt* p )){
   
+    PT_BEGIN(p);
     currentScreen = ALARM;
-    tft.fillRect(0, 0, 240, 200, BLACK);
+    PT_SPAWN(p, &clearThread, clearScreen(&clearThread));
     
     tft.setCursor(75, 0);                                                                                      
     tft.setTextColor(CYAN); tft.setTextSize(2); 
                                                                   
     tft.print("Alarms");                                                                                 
+    PT_YIELD(p);
+    
+    tft.setTextColor(CYAN);
     tft.setTextSize(1.5);
     
     tft.setCursor(0, 40);
@@ -159,27 +254,50 @@ void displayAlarmScreen (){
     
     tft.setCursor(120, 80);
     tft.print("NOT ACTIVE");
+    PT_YIELD(p);
     
-    return;
+    tft.setCursor(0, LIMIT_TOP);
+    tft.print("Voltage limit in: ");
+    
+    tft.setCursor(120, LIMIT_TOP);
+    tft.print("--");
+    
+    tft.setCursor(0, LIMIT_TOP + 20);
+    tft.print("Current limit in: ");
+    
+    tft.setCursor(120, LIMIT_TOP + 20);
+    tft.print("--");
+    localVoltageLimit = LIMIT_NONE;
+    localCurrentLimit = LIMIT_NONE;
+    PT_YIELD(p);
+    
+    alarmButtonDisplay();
+    
+    PT_END(p);
 }
 
 /*********************************************************************************
     * Function name: displayBatteryScreen
-    * Function inputs: void
-    * Function outputs: void
-    * Function description: Draws the battery labels on the battery screen. 
+    * Function inputs: pt* p
+    * Function outputs: char, PT_YIELDED until the screen is drawn
+    * Function description: Draws the battery labels on the battery screen, a slice
+    *                       per call. 
     * Author(s): Leonard Shin, Leika Yamada
     ******************************************************************************/
-void displayBatteryScreen (){
+PT_THREAD(displayBatteryScreen ( pt* p )){
     
+    PT_BEGIN(p);
     currentScreen = BATTERY;
-    tft.fillRect(0, 0, 240, 200, BLACK);
+    PT_SPAWN(p, &clearThread, clearScreen(&clearThread));
     batteryButtonDisplay();
+    PT_YIELD(p);
     
     tft.setCursor(25, 0);                                                                                    
     tft.setTextColor(CYAN); tft.setTextSize(2);                                                               
     tft.print("Battery ON/OFF");                                                                                
+    PT_YIELD(p);
     
+    tft.setTextColor(CYAN);
     tft.setTextSize(1.5);
     tft.setCursor(0, 40);
     tft.print("Current Battery State: ");
@@ -200,7 +318,52 @@ void displayBatteryScreen (){
             contactorAck = 0;
         }
     }
-    return; 
+    PT_END(p); 
+}
+
+/*********************************************************************************
+    * Function name: displayDiagnosticsScreen
+    * Function inputs: pt* p
+    * Function outputs: char, PT_YIELDED until the screen is drawn
+    * Function description: Draws the diagnostics labels, a slice per call. The
+    *                       values are left to updateDiagnosticsDisplay.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+PT_THREAD(displayDiagnosticsScreen ( pt* p )){
+
+    PT_BEGIN(p);
+    currentScreen = DIAGNOSTICS;
+    PT_SPAWN(p, &clearThread, clearScreen(&clearThread));
+
+    tft.setCursor(54, 0);
+    tft.setTextColor(CYAN); tft.setTextSize(2);
+    tft.print("Diagnostics");
+    PT_YIELD(p);
+
+    tft.setTextSize(1.5);
+    tft.setCursor(0, DIAG_TOP - DIAG_ROW_H - 2);
+    tft.print("Task");
+    tft.setCursor(DIAG_AVERAGE_X, DIAG_TOP - DIAG_ROW_H - 2);
+    tft.print("avg us");
+    tft.setCursor(DIAG_WORST_X, DIAG_TOP - DIAG_ROW_H - 2);
+    tft.print("max us");
+    tft.setCursor(DIAG_MISSES_X, DIAG_TOP - DIAG_ROW_H - 2);
+    tft.print("misses");
+    PT_YIELD(p);
+
+    for ( diagnosticsField = 0; diagnosticsField < TASK_COUNT; diagnosticsField++ ) {
+        tft.setCursor(0, DIAG_TOP + diagnosticsField * DIAG_ROW_H);
+        tft.print(allTasks[diagnosticsField]->name);
+        PT_YIELD(p);
+    }
+    for ( diagnosticsField = 0; diagnosticsField < DIAG_FIELDS - DIAG_TASK_FIELDS; diagnosticsField++ ) {
+        tft.setCursor(0, DIAG_TOP + ( TASK_COUNT + 1 + diagnosticsField ) * DIAG_ROW_H);
+        tft.print(diagnosticsLabels[diagnosticsField]);
+        PT_YIELD(p);
+    }
+    diagnosticsBlank = true;                                         // Every value is drawn by the first update
+
+    PT_END(p);
 }
 
 /*********************************************************************************
@@ -231,6 +394,7 @@ void updateMeasurementDisplay () {
         tft.fillRect(160, 60, 40, 20, BLACK);
         tft.setCursor(160, 60); 
         tft.print(localTemperature);
+        recordLatency(&latency.sampleToPixel, channels.channel[CHANNEL_TEMPERATURE].lastSample, micros());
       
     }
     if( hvCurrent != localHVCurrent ){                // Update HIVL current on screen if not already updated
@@ -239,6 +403,7 @@ void updateMeasurementDisplay () {
         tft.fillRect(160, 80, 40, 20, BLACK);
         tft.setCursor(160, 80); 
         tft.print(localHVCurrent);
+        recordLatency(&latency.sampleToPixel, channels.channel[CHANNEL_CURRENT].lastSample, micros());
       
     }
     if( hvVoltage != localHVVoltage ){                // Update HVVoltage on screen if not already updated
@@ -247,6 +412,7 @@ void updateMeasurementDisplay () {
         tft.fillRect(160, 100, 40, 20, BLACK);
         tft.setCursor(160, 100); 
         tft.print(localHVVoltage);
+        recordLatency(&latency.sampleToPixel, channels.channel[CHANNEL_VOLTAGE].lastSample, micros());
       
     }
     if( hVIL != localHVIL ){                          // Update HIVL status on screen if not already updated
@@ -255,11 +421,12 @@ void updateMeasurementDisplay () {
         tft.fillRect(160, 120, 40, 20, BLACK);
         tft.setCursor(160, 120);
         tft.setTextColor(CYAN);
-        if( localHVIL ){                              // Check if the dip switch is open or closed and print status
+        if( localHVIL == HVIL_OPEN ){                         // Check if the dip switch is open or closed and print status
             tft.print("OPEN");
         }else{
             tft.print("CLOSED");
         }
+        recordLatency(&latency.sampleToPixel, channels.channel[CHANNEL_HVIL].lastSample, micros());
       
     }
     return;
@@ -295,6 +462,36 @@ void updateBatteryDisplay ( bool* contactorState ) {
     return;
 }
 
+/*********************************************************************************
+    * Function name: updateTimeToLimit
+    * Function inputs: float timeToLimit, unsigned int* local, int16_t y
+    * Function outputs: void
+    * Function description: Shows a time to limit from the alarm task on row y of
+    *                       the alarm screen in whole seconds, or -- when the trend
+    *                       is not heading for a limit within LIMIT_SHOWN seconds.
+    *                       The row is only redrawn when the shown value changes.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void updateTimeToLimit ( float timeToLimit, unsigned int* local, int16_t y ) {
+
+    unsigned int seconds = ( timeToLimit <= LIMIT_SHOWN ) ? (unsigned int) ( timeToLimit + 0.5 ) : LIMIT_NONE;
+    
+    if( seconds != *local ){
+        *local = seconds;
+        tft.fillRect(120, y, 90, 20, BLACK);
+        tft.setCursor(120, y);
+        
+        if( seconds == LIMIT_NONE ){
+            tft.print("--");
+        }
+        else{
+            tft.print(seconds);
+            tft.print(" s");
+        }
+    }
+    return;
+}
+
 /*********************************************************************************
     * Function name: updateAlarmDisplay
     * Function inputs: void
@@ -329,6 +526,7 @@ void updateAlarmDisplay () {
             tft.setCursor(120, 40);
             tft.print("ACTIVE ACK.");
         } 
+        recordLatency(&latency.alarmToPixel, alarmStamp, micros());
     }
     
     if( hVoltOutofRange != localHVoltOutofRange ){           // Check HV out of range for updates, if 0 alarm is not active, if 1 active not acknowledged,
@@ -343,9 +541,13 @@ void updateAlarmDisplay () {
         else if(localHVoltOutofRange == 1){
             tft.print("ACTIVE NOT ACK.");
         }
+        else if(localHVoltOutofRange == PRE_WARNING){
+            tft.print("PRE-WARNING");
+        }
         else{
             tft.print("ACTIVE ACK.");
         } 
+        recordLatency(&latency.alarmToPixel, alarmStamp, micros());
     }
     
     if( overCurrent != localOverCurrent ){                // Check HV out of range for updates, if 0 alarm is not active, if 1 active not acknowledged,
@@ -360,14 +562,301 @@ void updateAlarmDisplay () {
         else if(localOverCurrent == 1){
           tft.print("ACTIVE NOT ACK.");
         }
+        else if(localOverCurrent == PRE_WARNING){
+          tft.print("PRE-WARNING");
+        }
         else{
           tft.print("ACTIVE ACK.");
         } 
+        recordLatency(&latency.alarmToPixel, alarmStamp, micros());
     }
     
+    updateTimeToLimit(voltageTimeToLimit, &localVoltageLimit, LIMIT_TOP);
+    updateTimeToLimit(currentTimeToLimit, &localCurrentLimit, LIMIT_TOP + 20);
+    
+    return;
+}
+
+/*********************************************************************************
+    * Function name: writeScrollCommand
+    * Function inputs: uint8_t command, const uint16_t* params, uint8_t count
+    * Function outputs: void
+    * Function description: Sends an ILI9341 command followed by count 16-bit
+    *                       parameters, high byte first. The library keeps its
+    *                       register writes private, so this drives the shield
+    *                       bus directly with the pin_magic.h macros.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void writeScrollCommand ( uint8_t command, const uint16_t* params, uint8_t count ) {
+
+    CS_ACTIVE;
+    CD_COMMAND;
+    write8(command);
+    CD_DATA;
+    for ( uint8_t i = 0; i < count; i++ ) {
+        uint8_t high = params[i] >> 8;
+        uint8_t low  = params[i] & 0xFF;
+        write8(high);
+        write8(low);
+    }
+    CS_IDLE;
+
     return;
 }
 
+/*********************************************************************************
+    * Function name: setTrendScroll
+    * Function inputs: bool enable
+    * Function outputs: void
+    * Function description: Limits the LCD hardware scroll area to the trend plot
+    *                       so the title and button bar stay fixed, or restores the
+    *                       full unscrolled screen for the other screens. Only the
+    *                       ILI9341 has a scroll area; on other controllers the plot
+    *                       wraps in place instead of scrolling.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void setTrendScroll ( bool enable ) {
+
+    if ( lcdIdentifier != 0x9341 ) {
+        return;
+    }
+
+    if ( enable ) {
+        uint16_t area[3] = {TREND_FIXED_TOP, HISTORY_LENGTH, TREND_FIXED_BOTTOM};
+        writeScrollCommand(LCD_VSCRDEF, area, 3);
+    }
+    else {
+        uint16_t area[3] = {0, LCD_HEIGHT, 0};
+        uint16_t start   = 0;
+        writeScrollCommand(LCD_VSCRDEF, area, 3);
+        writeScrollCommand(LCD_VSCRSADD, &start, 1);
+    }
+
+    return;
+}
+
+/*********************************************************************************
+    * Function name: drawTrendSample
+    * Function inputs: byte index
+    * Function outputs: void
+    * Function description: Draws history sample index on the next plot line: one
+    *                       black line to erase the oldest sample, then one pixel
+    *                       per channel. The viewport is moved by scrollTrend().
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void drawTrendSample ( byte index ) {
+
+    int16_t y = TREND_BOTTOM - trendLine;
+
+    tft.drawFastHLine(0, y, TREND_WIDTH, BLACK);
+    tft.drawPixel((uint16_t) history.temperature[index] * (TREND_WIDTH - 1) / 255, y, GREEN);
+    tft.drawPixel((uint16_t) history.current[index] * (TREND_WIDTH - 1) / 255, y, MAGENTA);
+    tft.drawPixel((uint16_t) history.voltage[index] * (TREND_WIDTH - 1) / 255, y, YELLOW);
+
+    trendLine = (trendLine + 1) % HISTORY_LENGTH;
+
+    return;
+}
+
+/*********************************************************************************
+    * Function name: scrollTrend
+    * Function inputs: void
+    * Function outputs: void
+    * Function description: Points the scroll start at the line that will be drawn
+    *                       next, which is the oldest one on screen. The newest
+    *                       sample then shows at the top of the plot and older ones
+    *                       move down one line per sample.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void scrollTrend () {
+
+    if ( lcdIdentifier == 0x9341 ) {
+        uint16_t start = TREND_FIXED_TOP + trendLine;
+        writeScrollCommand(LCD_VSCRSADD, &start, 1);
+    }
+
+    return;
+}
+
+/*********************************************************************************
+    * Function name: drawPendingTrend
+    * Function inputs: byte maxLines
+    * Function outputs: bool, true if samples are still waiting to be drawn
+    * Function description: Plots up to maxLines of the samples pushed since the
+    *                       last one drawn, oldest first. Samples that already left
+    *                       the history buffer are skipped.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+bool drawPendingTrend ( byte maxLines ) {
+
+    if ( history.total - localHistoryTotal > history.count ) {        // Only what is still in the buffer can be drawn
+        localHistoryTotal = history.total - history.count;
+    }
+    while ( maxLines > 0 && localHistoryTotal != history.total ) {
+        drawTrendSample(historyIndex(&history, history.total - localHistoryTotal - 1));
+        localHistoryTotal++;
+        maxLines--;
+    }
+
+    return localHistoryTotal != history.total;
+}
+
+/*********************************************************************************
+    * Function name: displayTrendScreen
+    * Function inputs: pt* p
+    * Function outputs: char, PT_YIELDED until the screen is drawn
+    * Function description: Draws the trend screen title and legend, sets up the
+    *                       scroll area and plots everything still in the history
+    *                       buffer, oldest first, TREND_SLICE_LINES lines per call.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+PT_THREAD(displayTrendScreen ( pt* p )) {
+
+    PT_BEGIN(p);
+    currentScreen = TREND;
+    PT_SPAWN(p, &clearThread, clearScreen(&clearThread));
+
+    tft.setCursor(0, 0);
+    tft.setTextColor(CYAN); tft.setTextSize(2);
+    tft.print("Trend");
+
+    tft.setTextSize(1.5);
+    tft.setCursor(100, 4);
+    tft.setTextColor(YELLOW);  tft.print("Volt ");
+    tft.setTextColor(MAGENTA); tft.print("Curr ");
+    tft.setTextColor(GREEN);   tft.print("Temp");
+
+    setTrendScroll(true);
+    trendLine = 0;
+    scrollTrend();
+    localHistoryTotal = history.total - history.count;
+    while ( drawPendingTrend(TREND_SLICE_LINES) ) {
+        PT_YIELD(p);
+    }
+    scrollTrend();
+
+    PT_END(p);
+}
+
+/*********************************************************************************
+    * Function name: updateTrendDisplay
+    * Function inputs: void
+    * Function outputs: void
+    * Function description: Plots the samples pushed since the last update, one
+    *                       plot line each, then shifts the viewport. The cost per
+    *                       sample does not depend on the plot width or length.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void updateTrendDisplay () {
+
+    if ( localHistoryTotal == history.total ) {
+        return;
+    }
+    drawPendingTrend(HISTORY_LENGTH);
+    scrollTrend();
+
+    return;
+}
+
+/*********************************************************************************
+    * Function name: readDiagnostics
+    * Function inputs: void
+    * Function outputs: void
+    * Function description: Takes the values the diagnostics screen shows, so all
+    *                       fields of one update come from the same moment.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void readDiagnostics () {
+
+    for ( byte i = 0; i < TASK_COUNT; i++ ) {
+        diagnosticsValues[i * 3]     = allTasks[i]->stats.average;
+        diagnosticsValues[i * 3 + 1] = allTasks[i]->stats.worst;
+        diagnosticsValues[i * 3 + 2] = allTasks[i]->stats.misses;
+    }
+    diagnosticsValues[DIAG_IDLE]    = scheduler.idle;
+    diagnosticsValues[DIAG_STACK]   = stackHeadroom();
+    diagnosticsValues[DIAG_QUEUED]  = telemetryFrames.count;
+    diagnosticsValues[DIAG_DEEPEST] = telemetryFrames.deepest;
+    diagnosticsValues[DIAG_DROPPED] = telemetryFrames.dropped;
+
+    return;
+}
+
+/*********************************************************************************
+    * Function name: drawDiagnosticsField
+    * Function inputs: byte field
+    * Function outputs: void
+    * Function description: Erases one value of the diagnostics screen and prints
+    *                       the new one in its place.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void drawDiagnosticsField ( byte field ) {
+
+    unsigned int value = diagnosticsValues[field];
+    int16_t x, y, w;
+
+    if ( field < DIAG_TASK_FIELDS ) {
+        x = ( field % 3 == 0 ) ? DIAG_AVERAGE_X : ( field % 3 == 1 ) ? DIAG_WORST_X : DIAG_MISSES_X;
+        y = DIAG_TOP + field / 3 * DIAG_ROW_H;
+        w = DIAG_FIELD_W;
+    }
+    else {
+        x = DIAG_VALUE_X;
+        y = DIAG_TOP + ( TASK_COUNT + 1 + field - DIAG_TASK_FIELDS ) * DIAG_ROW_H;
+        w = DIAG_VALUE_W;
+    }
+
+    tft.fillRect(x, y, w, 8, BLACK);
+    tft.setCursor(x, y);
+    tft.setTextSize(1.5);
+    tft.setTextColor(CYAN);
+    if ( field == DIAG_STACK && value == STACK_UNKNOWN ) {
+        tft.print("n/a");
+    }
+    else {
+        tft.print(value);
+        if ( field == DIAG_IDLE ) {
+            tft.print("%");
+        }
+        else if ( field == DIAG_STACK ) {
+            tft.print(" bytes");
+        }
+        else if ( field == DIAG_QUEUED || field == DIAG_DEEPEST ) {
+            tft.print(" of ");
+            tft.print(TELEMETRY_QUEUE);
+        }
+    }
+
+    return;
+}
+
+/*********************************************************************************
+    * Function name: updateDiagnosticsDisplay
+    * Function inputs: pt* p
+    * Function outputs: char, PT_YIELDED after every value it redraws
+    * Function description: Brings the diagnostics screen up to a fresh snapshot,
+    *                       redrawing only the values that changed and one per
+    *                       scheduler pass, so looking at the numbers costs the
+    *                       tasks being measured next to nothing.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+PT_THREAD(updateDiagnosticsDisplay ( pt* p )) {
+
+    PT_BEGIN(p);
+    readDiagnostics();
+
+    for ( diagnosticsField = 0; diagnosticsField < DIAG_FIELDS; diagnosticsField++ ) {
+        if ( diagnosticsBlank || diagnosticsValues[diagnosticsField] != localDiagnostics[diagnosticsField] ) {
+            drawDiagnosticsField(diagnosticsField);
+            localDiagnostics[diagnosticsField] = diagnosticsValues[diagnosticsField];
+            PT_YIELD(p);
+        }
+    }
+    diagnosticsBlank = false;
+
+    PT_END(p);
+}
+
 /*********************************************************************************
     * Function name: updateDisplay
     * Function inputs: void
@@ -376,17 +865,18 @@ void updateAlarmDisplay () {
     *                       status.If a button is pressed update the button flag
     *                       variables so that the screen is switched to the desired
     *                       screen. If a battery ON/OFF button is pressed update 
-    *                       the contactorState variable.
+    *                       the contactorState variable. If the alarm ACK button
+    *                       is pressed flag the alarms to be acknowledged.
     * Author(s): Leonard Shin, Leika Yamada
     ******************************************************************************/
 void updateDisplay (){
   
-    digitalWrite(13, HIGH);
+    gpioPin<LED_PIN>::write(HIGH);
     TSPoint p = ts.getPoint();                                                        // Capture touchscreen x, y, z pressure coordinates
-    digitalWrite(13, LOW);
+    gpioPin<LED_PIN>::write(LOW);
     
-    pinMode(XM, OUTPUT);                                                              // Configure LCD screen pins
-    pinMode(YP, OUTPUT);
+    gpioPin<XM>::output();                                                            // getPoint() leaves the pins the LCD shares as inputs, take them back
+    gpioPin<YP>::output();
                                                                                       // Code is based on Arduino phonecal.ino example file
     if ( p.z > MINPRESSURE && p.z < MAXPRESSURE ) {                                   // Check if sufficient pressure is applied, if it is get coordinates.
         p.x = map(p.x, TS_MINX, TS_MAXX, tft.width(), 0);
@@ -416,20 +906,35 @@ void updateDisplay (){
                                                                                       // OFF button is pressed,  update contactor to open
             if (b == 0) {
                 contactorState = 0;
+                contactorStamp = micros();                                            // Start the command to pin latency trace
             }
         
                                                                                       // ON button is pressed, update contactor to closed
             if (b == 1) {
                 contactorState = 1;
+                contactorStamp = micros();
             }
         
         /*delay(100); uncomment to debounce UI*/
         }
       }
     }
+    
+    if( currentScreen == ALARM ){
+                                                                                      // Check if the ACK button is pressed
+        if ( alarmAckButton.contains(p.x, p.y) ) {
+            alarmAckButton.press(true);
+        } else {
+            alarmAckButton.press(false);
+        }
+                                                                                      // ACK button is pressed, the alarm task acknowledges the active alarms
+        if ( alarmAckButton.justPressed() ) {
+            alarmAcknowledge = true;
+        }
+    }
    
-                                                                                        // Check if measurement, alarm, or battery button is pressed
-    for ( uint8_t b=0; b<3; b++ ) {
+                                                                                        // Check if measurement, alarm, battery, trend, or diagnostics button is pressed
+    for ( uint8_t b=0; b<SCREEN_BUTTONS; b++ ) {
       
         if (buttons[b].contains(p.x, p.y)) {
           
@@ -439,7 +944,7 @@ void updateDisplay (){
         }
     }
 
-    for ( uint8_t b=0; b<3; b++ ) {
+    for ( uint8_t b=0; b<SCREEN_BUTTONS; b++ ) {
       
         if (buttons[b].justReleased()) {
       
@@ -461,6 +966,14 @@ void updateDisplay (){
                                                                                         // battery button is pressed,  flag battery screen
             if (b == 2) {
                 batteryButton = true;
+            }
+                                                                                        // trend button is pressed,  flag trend screen
+            if (b == 3) {
+                trendButton = true;
+            }
+                                                                                        // diagnostics button is pressed,  flag diagnostics screen
+            if (b == 4) {
+                diagnosticsButton = true;
             }
         
         /*delay(100); uncomment for UI debounce*/
@@ -468,37 +981,55 @@ void updateDisplay (){
     }  
 }
 /*********************************************************************************
-    * Function name: displayTask
-    * Function inputs: void* dispData
-    * Function outputs: void
+    * Function name: displayThread
+    * Function inputs: pt* p, displayData* data
+    * Function outputs: char, PT_YIELDED while a screen is being drawn
     * Function description: Update the screen that is displayed based on buttons
     *                       pushed on the TFT screen. Check which screen the user
     *                       is currently on. Then call functions to check if the 
     *                       values on the displayed screen needs to be updated.
+    *                       A new screen is drawn in slices, yielding back to the
+    *                       scheduler between them.
     * Author(s): Leonard Shin, Leika Yamada
     ******************************************************************************/
-void displayTask ( void* dispData ) {
+PT_THREAD(displayThread ( pt* p, displayData* data )) {
    
-    displayData* data = (displayData*) dispData;                                          // Display correct screen on button press
+    PT_BEGIN(p);                                                                          // Display correct screen on button press
     updateDisplay();                                                                      // Print the main display page                                                                   
+                                                                                          // Leaving the trend screen, give the other screens an unscrolled panel
+    if ( currentScreen == TREND && ( measureButton || alarmButton || batteryButton || diagnosticsButton ) ) {
+        setTrendScroll(false);
+    }
                                                                                           // Check if any buttons are pressed, then display the cooresponding screen
     if ( measureButton == true ){
       
-        displayMeasurementScreen();
+        PT_SPAWN(p, &screenThread, displayMeasurementScreen(&screenThread));
                                                                                           // Reset measure button to be false, so code does not repeatedly execute
         measureButton = false;  
     }
     else if ( alarmButton == true ){
       
-        displayAlarmScreen();
+        PT_SPAWN(p, &screenThread, displayAlarmScreen(&screenThread));
                                                                                           // Reset alarm button to be false, so code does not repeatedly execute
         alarmButton = false;  
     }
     else if ( batteryButton == true ){
       
-        displayBatteryScreen();
+        PT_SPAWN(p, &screenThread, displayBatteryScreen(&screenThread));
                                                                                           // Reset measure button to be false, so code does not repeatedly execute
         batteryButton = false;  
+    }
+    else if ( trendButton == true ){
+      
+        PT_SPAWN(p, &screenThread, displayTrendScreen(&screenThread));
+                                                                                          // Reset trend button to be false, so code does not repeatedly execute
+        trendButton = false;  
+    }
+    else if ( diagnosticsButton == true ){
+      
+        PT_SPAWN(p, &screenThread, displayDiagnosticsScreen(&screenThread));
+                                                                                          // Reset diagnostics button to be false, so code does not repeatedly execute
+        diagnosticsButton = false;  
     }
                                                                                           // Check the current screen, then update the values on those screens
     if( currentScreen == MEASURE ){
@@ -509,10 +1040,35 @@ void displayTask ( void* dispData ) {
       
       updateAlarmDisplay();
     }
+    else if( currentScreen == TREND ){
+      
+      updateTrendDisplay();
+    }
+    else if( currentScreen == DIAGNOSTICS ){
+      
+      PT_SPAWN(p, &screenThread, updateDiagnosticsDisplay(&screenThread));
+    }
     else{
       
       updateBatteryDisplay(data->contactorState);
     } 
     
+    PT_END(p);
+}
+
+/*********************************************************************************
+    * Function name: displayTask
+    * Function inputs: void* dispData
+    * Function outputs: void
+    * Function description: Runs the display protothread for one slice. The
+    *                       scheduler calls it again every pass until the frame
+    *                       is finished, see PT_RUNNING in the display TCB.
+    * Author(s): Leonard Shin, Leika Yamada
+    ******************************************************************************/
+void displayTask ( void* dispData ) {
+   
+    displayData* data = (displayData*) dispData;
+    displayThread(data->thread, data);
+    
   return;
 }
@@ -14,12 +14,22 @@ extern "C" {
 #include <pin_magic.h>
 #include <registers.h>
 #include <TouchScreen.h>
+#include "History.h"
+#include "Protothread.h"
+#include "Measurement.h"
+#include "Latency.h"
+#include "TaskControlBlock.h"
+#include "Diagnostics.h"
+#include "Telemetry.h"
+#include "Alarm.h"
 
 
 /* Tags for the current screen displayed*/
 #define MEASURE 0x00
 #define ALARM 0x01
 #define BATTERY 0x02
+#define TREND 0x03
+#define DIAGNOSTICS 0x04
 
 /* Assign human-readable names to some common 16-bit color values*/
 #define  BLACK   0x0000
@@ -34,10 +44,11 @@ extern "C" {
 /*Buttons Sizing*/ 
 #define BUTTON_X 50
 #define BUTTON_Y 250
-#define BUTTON_W 70
+#define BUTTON_W 46
 #define BUTTON_H 30
-#define BUTTON1_SPACING_X 43
-#define BUTTON2_SPACING_X 77
+#define BUTTON1_SPACING_X 24
+#define BUTTON2_SPACING_X 48
+#define SCREEN_BUTTONS 5
 #define BUTTON_TEXTSIZE 1
 
 #define BATTERY_BUTTON_X 50
@@ -45,6 +56,43 @@ extern "C" {
 #define BATTERY_BUTTON_W 80
 #define BATTERY_BUTTON_H 50
 
+#define ACK_BUTTON_X 120
+#define ACK_BUTTON_Y 170
+
+/*Screen redraw slices: the background is cleared one band per scheduler pass*/
+#define CLEAR_BANDS 10
+#define CLEAR_BAND_H 20
+#define TREND_SLICE_LINES 20
+
+/*Diagnostics screen layout, one row per task then the scheduler and queue rows*/
+#define DIAG_TOP 40
+#define DIAG_ROW_H 12
+#define DIAG_AVERAGE_X 84
+#define DIAG_WORST_X 132
+#define DIAG_MISSES_X 180
+#define DIAG_FIELD_W 42
+#define DIAG_VALUE_X 132
+#define DIAG_VALUE_W 108
+
+/*Alarm screen time to limit rows, in whole seconds*/
+#define LIMIT_TOP 100
+#define LIMIT_SHOWN 999                 // Longer times are shown as --
+#define LIMIT_NONE 0xFFFF               // No time shown
+
+/*Trend screen plot area, one plot line per history sample. The LCD is used
+ *with setRotation(2), so screen row y is panel line LCD_HEIGHT - 1 - y and the
+ *hardware scroll area below is given in panel lines.*/
+#define TREND_TOP 20
+#define TREND_BOTTOM ( TREND_TOP + HISTORY_LENGTH - 1 )
+#define TREND_WIDTH 240
+#define LCD_HEIGHT 320
+#define TREND_FIXED_TOP ( LCD_HEIGHT - 1 - TREND_BOTTOM )       // Panel lines below the plot: button bar
+#define TREND_FIXED_BOTTOM TREND_TOP                          // Panel lines above the plot: screen title
+
+/*ILI9341 vertical scrolling commands*/
+#define LCD_VSCRDEF 0x33
+#define LCD_VSCRSADD 0x37
+
 /*Button adjustment spacing*/
 #define ONE 1
 
@@ -64,13 +112,14 @@ extern "C" {
 #define MINPRESSURE 10
 #define MAXPRESSURE 1000
 
+/*On board LED, lit while the touch screen is read*/
+#define LED_PIN 13
+
 
 typedef struct displayTaskData {      // Data structure for the display task, 
-                                      // Stores the HVIL, and Contactor input/output pin number
                                       // Stores the current contactor state, Open or closed
-    const byte* hvilPin;
     bool* contactorState;
-    int* contactorLED;
+    pt* thread;                       // Resume point of the display protothread, lives in the display TCB
     
 } displayData;
 
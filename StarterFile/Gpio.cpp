@@ -0,0 +1,18 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <Arduino.h>
+#include "Gpio.h"
+#include "Measurement.h"
+
+/*****************************************************************
+  * Function name: readHvilInput
+  * Function inputs: void
+  * Function outputs: bool, the level of HVIL_PIN
+  * Function description: reads the HVIL input for the C modules,
+  *                       which cannot use the gpioPin template
+  * Author(s): Leonard Shin, Leika Yamada
+  *****************************************************************/
+bool readHvilInput ( void ) {
+
+    return gpioPin<HVIL_PIN>::read();
+}
@@ -0,0 +1,123 @@
+#ifndef GPIO_H_
+#define GPIO_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+
+/* Compile time GPIO for the Arduino Mega. gpioPin<N> is pin N of the board,
+ * numbered as for digitalRead()/digitalWrite(); the port register and bit
+ * are worked out by the compiler, so with N a constant a read is one
+ * sbic/sbis or in and a write one sbi/cbi, against the tens of cycles
+ * digitalWrite() spends on its flash table lookups. Ports H to L sit above
+ * the I/O space the bit instructions reach, their writes are a load and a
+ * store with interrupts held off.
+ * Unlike digitalWrite() nothing switches a timer's PWM off the pin, so do
+ * not use these on pins driven by analogWrite().
+ * On the host the pins are the thread's hostPinLevel[] of Host/Arduino.h.*/
+#define GPIO_PINS   70
+
+
+#ifdef __cplusplus
+
+/* Port of every pin, A = 0 ... G = 6, H = 7, J = 8, K = 9, L = 10*/
+constexpr uint8_t gpioPort[GPIO_PINS] = {
+    4, 4, 4, 4, 6, 4, 7, 7, 7, 7,       //  0 -  9  PE0 PE1 PE4 PE5 PG5 PE3 PH3 PH4 PH5 PH6
+    1, 1, 1, 1, 8, 8, 7, 7, 3, 3,       // 10 - 19  PB4 PB5 PB6 PB7 PJ1 PJ0 PH1 PH0 PD3 PD2
+    3, 3, 0, 0, 0, 0, 0, 0, 0, 0,       // 20 - 29  PD1 PD0 PA0 - PA7
+    2, 2, 2, 2, 2, 2, 2, 2, 3, 6,       // 30 - 39  PC7 - PC0 PD7 PG2
+    6, 6, 10, 10, 10, 10, 10, 10, 10, 10,   // 40 - 49  PG1 PG0 PL7 - PL0
+    1, 1, 1, 1, 5, 5, 5, 5, 5, 5,       // 50 - 59  PB3 PB2 PB1 PB0 PF0 - PF5 (A0 - A5)
+    5, 5, 9, 9, 9, 9, 9, 9, 9, 9        // 60 - 69  PF6 PF7 PK0 - PK7 (A6 - A15)
+};
+
+/* Bit of every pin in its port*/
+constexpr uint8_t gpioBit[GPIO_PINS] = {
+    0, 1, 4, 5, 5, 3, 3, 4, 5, 6,
+    4, 5, 6, 7, 1, 0, 1, 0, 3, 2,
+    1, 0, 0, 1, 2, 3, 4, 5, 6, 7,
+    7, 6, 5, 4, 3, 2, 1, 0, 7, 2,
+    1, 0, 7, 6, 5, 4, 3, 2, 1, 0,
+    3, 2, 1, 0, 0, 1, 2, 3, 4, 5,
+    6, 7, 0, 1, 2, 3, 4, 5, 6, 7
+};
+
+/* Data space address of the PINx register of every port, DDRx and PORTx follow it*/
+constexpr uint16_t gpioPortBase[11] = {
+    0x20, 0x23, 0x26, 0x29, 0x2C, 0x2F, 0x32, 0x100, 0x103, 0x106, 0x109
+};
+
+
+template <uint8_t Pin>
+struct gpioPin {
+    static_assert(Pin < GPIO_PINS, "not an Arduino Mega pin");
+
+#if defined(__AVR__)
+    static constexpr uint16_t base = gpioPortBase[gpioPort[Pin]];
+    static constexpr uint8_t mask = 1 << gpioBit[Pin];
+    static constexpr bool bitAddressable = base < 0x40;        // I/O addresses 0x00 - 0x1F
+
+    static inline bool read ( void ) {
+        return ( *(volatile uint8_t*) base & mask ) != 0;
+    }
+    static inline void write ( bool level ) {
+        change(base + 2, level);
+    }
+    static inline void output ( void ) {
+        change(base + 1, true);
+    }
+    static inline void input ( void ) {                         // As pinMode(INPUT), the pull up is turned off too
+        change(base + 1, false);
+        change(base + 2, false);
+    }
+
+private:
+    static inline __attribute__((always_inline)) void change ( uint16_t address, bool set ) {   // Inlined, so address is a constant
+        volatile uint8_t* reg = (volatile uint8_t*) address;
+        if( bitAddressable ){
+            if( set ){
+                *reg |= mask;
+            }
+            else {
+                *reg &= (uint8_t) ~mask;
+            }
+        }
+        else {
+            uint8_t sreg = SREG;                                // An interrupt writing the same port must not land between the load and the store
+            cli();
+            *reg = set ? ( *reg | mask ) : ( *reg & (uint8_t) ~mask );
+            SREG = sreg;
+        }
+    }
+#else
+    static inline bool read ( void ) {
+        return hostPinLevel[Pin] != LOW;
+    }
+    static inline void write ( bool level ) {
+        hostPinLevel[Pin] = level ? HIGH : LOW;
+    }
+    static inline void output ( void ) {
+    }
+    static inline void input ( void ) {
+    }
+#endif
+};
+
+#endif    // __cplusplus
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool readHvilInput (void);              // HVIL_PIN through gpioPin, for the C modules
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "History.h"
+#include "Arduino.h"
+
+/*****************************************************************
+  * Function name: quantize
+  * Function inputs: float value, float low, float high
+  * Function outputs: byte
+  * Function description: maps value from [low, high] onto 0-255,
+  *                       clamping anything outside the range
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static byte quantize ( float value, float low, float high ) {
+
+    if( value <= low ){
+        return 0;
+    }
+    if( value >= high ){
+        return 255;
+    }
+    return (byte) ( ( value - low ) * 255 / ( high - low ) );
+}
+
+/*****************************************************************
+  * Function name: pushHistory
+  * Function inputs: trendHistory* history, float voltage,
+  *                  float current, float temperature
+  * Function outputs: void
+  * Function description: stores one quantized sample of each
+  *                       channel, overwriting the oldest sample
+  *                       once the buffer is full
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void pushHistory ( trendHistory* history, float voltage, float current, float temperature ) {
+
+    history->voltage[history->head]     = quantize(voltage, HISTORY_VOLTAGE_MIN, HISTORY_VOLTAGE_MAX);
+    history->current[history->head]     = quantize(current, HISTORY_CURRENT_MIN, HISTORY_CURRENT_MAX);
+    history->temperature[history->head] = quantize(temperature, HISTORY_TEMP_MIN, HISTORY_TEMP_MAX);
+
+    history->head = ( history->head + 1 ) % HISTORY_LENGTH;
+    if( history->count < HISTORY_LENGTH ){
+        history->count++;
+    }
+    history->total++;
+}
+
+/*****************************************************************
+  * Function name: historyIndex
+  * Function inputs: const trendHistory* history, byte age
+  * Function outputs: byte
+  * Function description: returns the ring index of the sample that
+  *                       was pushed age samples before the newest
+  *                       one (age 0 is the newest sample)
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+byte historyIndex ( const trendHistory* history, byte age ) {
+
+    return ( history->head + HISTORY_LENGTH - 1 - age ) % HISTORY_LENGTH;
+}
@@ -0,0 +1,43 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <Arduino.h>
+
+
+#define HISTORY_LENGTH      180         // Samples kept per channel, one per plot line on the trend screen
+
+/* Value ranges mapped onto the 0-255 code stored for each sample*/
+#define HISTORY_VOLTAGE_MIN 0.0
+#define HISTORY_VOLTAGE_MAX 500.0
+#define HISTORY_CURRENT_MIN -25.0
+#define HISTORY_CURRENT_MAX 25.0
+#define HISTORY_TEMP_MIN    -20.0
+#define HISTORY_TEMP_MAX    40.0
+
+
+typedef struct trendHistoryData {       // Ring buffer of quantized samples, one byte per channel per sample
+    byte voltage[HISTORY_LENGTH];
+    byte current[HISTORY_LENGTH];
+    byte temperature[HISTORY_LENGTH];
+    byte head;                          // Index the next sample is written to
+    byte count;                         // Number of valid samples, at most HISTORY_LENGTH
+    unsigned long total;                // Samples pushed since start, readers compare it to their local copy
+} trendHistory;
+
+
+void pushHistory (trendHistory* history, float voltage, float current, float temperature);
+byte historyIndex (const trendHistory* history, byte age);      // Ring index of the sample age steps before the newest
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
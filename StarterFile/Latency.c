@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "Latency.h"
+#include "Arduino.h"
+
+/*****************************************************************
+  * Function name: recordLatency
+  * Function inputs: latencyHistogram* histogram,
+  *                  unsigned long stamp, unsigned long now
+  * Function outputs: void
+  * Function description: counts the age now - stamp (micros) in
+  *                       its power of two bucket. The subtraction
+  *                       is wrap safe, so ages stay right across
+  *                       the 70 minute micros() rollover.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void recordLatency ( latencyHistogram* histogram, unsigned long stamp, unsigned long now ) {
+
+    unsigned long age = now - stamp;
+    byte bucket = 0;
+
+    while( ( age >> bucket ) != 0 && bucket < LATENCY_BUCKETS - 1 ){
+        bucket++;
+    }
+    if( histogram->count[bucket] != 0xFFFF ){
+        histogram->count[bucket]++;
+    }
+    if( age > histogram->maximum ){
+        histogram->maximum = age;
+    }
+    histogram->samples++;
+}
+
+/*****************************************************************
+  * Function name: latencyBucketLimit
+  * Function inputs: byte bucket
+  * Function outputs: unsigned long
+  * Function description: returns the largest age in microseconds
+  *                       that is counted in bucket
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+unsigned long latencyBucketLimit ( byte bucket ) {
+
+    if( bucket >= LATENCY_BUCKETS - 1 ){
+        return 0xFFFFFFFFUL;
+    }
+    return ( 1UL << bucket ) - 1;
+}
+
+/*****************************************************************
+  * Function name: latencyPercentile
+  * Function inputs: const latencyHistogram* histogram,
+  *                  byte percent
+  * Function outputs: unsigned long
+  * Function description: returns an upper bound, in microseconds,
+  *                       on the given percentile of recorded ages
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+unsigned long latencyPercentile ( const latencyHistogram* histogram, byte percent ) {
+
+    unsigned long total = 0;
+    unsigned long seen = 0;
+
+    for( byte b = 0; b < LATENCY_BUCKETS; b++ ){
+        total += histogram->count[b];
+    }
+    for( byte b = 0; b < LATENCY_BUCKETS; b++ ){
+        seen += histogram->count[b];
+        if( total != 0 && seen * 100 >= total * percent ){
+            return ( latencyBucketLimit(b) < histogram->maximum ) ? latencyBucketLimit(b) : histogram->maximum;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <Arduino.h>
+
+
+/* Bucket 0 counts ages of 0 us, bucket b counts ages in [2^(b-1), 2^b) us,
+ * and the last bucket collects everything from about 4 s up.*/
+#define LATENCY_BUCKETS 24
+
+
+typedef struct latencyHistogramData {       // Log2 histogram of how old data was when it reached a sink
+    unsigned int count[LATENCY_BUCKETS];    // Saturates at 65535 per bucket
+    unsigned long samples;
+    unsigned long maximum;                  // Worst age seen, in microseconds
+} latencyHistogram;
+
+typedef struct latencyTraceData {           // One histogram per path from a sample to its effect
+    latencyHistogram sampleToAlarm;         // Sensor sample to alarm decision
+    latencyHistogram alarmToPixel;          // Alarm change to alarm screen update
+    latencyHistogram sampleToPixel;         // Sensor sample to measurement screen update
+    latencyHistogram commandToPin;          // Contactor request to contactor output pin
+} latencyTrace;
+
+
+void recordLatency (latencyHistogram* histogram, unsigned long stamp, unsigned long now);   // Count one age of now - stamp (micros)
+unsigned long latencyPercentile (const latencyHistogram* histogram, byte percent);          // Upper bound of the bucket holding the percentile
+unsigned long latencyBucketLimit (byte bucket);                                             // Largest age counted in bucket
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
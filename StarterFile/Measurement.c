@@ -1,34 +1,36 @@
 #include <stdlib.h>
 #include <stdbool.h>
+#include <math.h>
 #include "Measurement.h"
+#include "Alarm.h"
+#include "Gpio.h"
 #include "Arduino.h"
 
 
 /**************************************************************************
   * Function name: updateHVIL
-  * Function inputs: bool* hvilReading, const byte* pin
+  * Function inputs: bool* hvilReading
   * Function outputs: void
   * Function description: changes hvilReading to represent the
-  *                      voltage (by expressing 0 or 1) on the provided pin
+  *                      voltage (by expressing 0 or 1) on HVIL_PIN
   * Author(s): Leonard Shin; Leika Yamada
   *************************************************************************/
-void updateHVIL ( bool* hvilReading, const byte* pin ) {
+void updateHVIL ( bool* hvilReading ) {
   
-    *hvilReading = digitalRead(*pin);
+    *hvilReading = readHvilInput();
 
 }
 
 /***************************************************************************
   * Function name: updateTemperature
-  * Function inputs: float* temperatureReading
+  * Function inputs: float* temperatureReading, byte clockTick
   * Function outputs: ~
   * Function description:  alters temperatureReading to cycle between
   *                       [-10, 5, 25], switching value every 1 sec
   * Author(s):  Leonard Shin; Leika Yamada
   **************************************************************************/
-void updateTemperature ( float* temperatureReading ) {
+void updateTemperature ( float* temperatureReading, byte clockTick ) {
   
-    extern byte clockTick;
     if ( clockTick % 3 == 0 ) {
         *temperatureReading = -10;
     }
@@ -42,15 +44,14 @@ void updateTemperature ( float* temperatureReading ) {
 
 /*******************************************************************
   *  Function name: updateHvCurrent
-  *  Function inputs: float* currentReading
+  *  Function inputs: float* currentReading, byte clockTick
   *  Function outputs: ~
   *  Function description:  alters currentReading to cycle between
   *                       [-20, 0, 20], switching value every 2 sec
   *  Author(s):  Leonard Shin; Leika Yamada
   ******************************************************************/
-void updateHvCurrent ( float* currentReading ) {
+void updateHvCurrent ( float* currentReading, byte clockTick ) {
   
-    extern byte clockTick;
     if (clockTick / 2 % 3 == 0) {
         *currentReading = -20;
     }
@@ -63,42 +64,376 @@ void updateHvCurrent ( float* currentReading ) {
 }
 /********************************************************************
   * Function name: updateHvVoltage
-  * Function inputs: float* voltageReading
+  * Function inputs: float* voltageReading, byte clockTick
   * Function outputs: ~
   * Function description: alters voltageReading to cycle between
-  *                       [10, 150, 450], switching value every 3 sec
+  *                       [300, 370, 420], switching value every 3 sec,
+  *                       so it spends one step over VOLTAGE_MAX
   * Author(s): Leonard Shin; Leika Yamada
   *******************************************************************/
-void updateHvVoltage ( float* voltageReading ) {
+void updateHvVoltage ( float* voltageReading, byte clockTick ) {
 
-    extern byte clockTick;
     if (clockTick / 3 % 3 == 0) {
-        *voltageReading = 10;
+        *voltageReading = 300;
     }
     else if (clockTick / 3 % 3 == 1) {
-        *voltageReading = 150;
+        *voltageReading = 370;
     }
     else {
-        *voltageReading = 450;
+        *voltageReading = 420;
     }
 }
 
+/*********************************************************************
+  * Function name: simulatedHvil, simulatedCurrent, simulatedVoltage,
+  *                simulatedTemperature
+  * Function inputs: void* context, the pack's measurementData
+  * Function outputs: the reading
+  * Function description: sensor source of the lab board, the HVIL
+  *                       pin and the values that cycle with the
+  *                       pack's own clockTick
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static bool simulatedHvil ( void* context ) {
+
+    bool reading;
+    (void) context;
+    updateHVIL(&reading);
+    return reading;
+}
+
+static float simulatedCurrent ( void* context ) {
+
+    measurementData* data = (measurementData*) context;
+    float reading;
+    updateHvCurrent(&reading, *data->clockTick);
+    return reading;
+}
+
+static float simulatedVoltage ( void* context ) {
+
+    measurementData* data = (measurementData*) context;
+    float reading;
+    updateHvVoltage(&reading, *data->clockTick);
+    return reading;
+}
+
+static float simulatedTemperature ( void* context ) {
+
+    measurementData* data = (measurementData*) context;
+    float reading;
+    updateTemperature(&reading, *data->clockTick);
+    return reading;
+}
+
+const sensorSource simulatedSensors = {
+    simulatedHvil, simulatedCurrent, simulatedVoltage, simulatedTemperature
+};
+
+/* Default settings, indexed by CHANNEL_*. HVIL is the safety input so it is
+ * checked first; every channel starts unfiltered. Current and voltage adapt
+ * their rate to how close they are to their alarm limits, the rest run at a
+ * fixed rate.*/
+static const channelConfig defaultChannelConfig[MEASUREMENT_CHANNELS] = {
+    { HVIL_PERIOD,        0, 1.0, HVIL_PERIOD,        HVIL_PERIOD,        0, 0, 0 },
+    { CURRENT_PERIOD,     1, 1.0, CURRENT_MIN_PERIOD, CURRENT_MAX_PERIOD, CURRENT_MIN, CURRENT_MAX, 1.0 },
+    { VOLTAGE_PERIOD,     2, 1.0, VOLTAGE_MIN_PERIOD, VOLTAGE_MAX_PERIOD, VOLTAGE_MIN, VOLTAGE_MAX, 5.0 },
+    { TEMPERATURE_PERIOD, 3, 1.0, TEMPERATURE_PERIOD, TEMPERATURE_PERIOD, 0, 0, 0 },
+    { HISTORY_PERIOD,     4, 1.0, HISTORY_PERIOD,     HISTORY_PERIOD,     0, 0, 0 }
+};
+
+/*********************************************************************
+  * Function name: filterSample
+  * Function inputs: const samplingChannel* channel, float raw,
+  *                  float* output
+  * Function outputs: void
+  * Function description: low pass filters raw into output using the
+  *                       channel's filter weight. output holds the
+  *                       previous filtered value, so no other state
+  *                       is needed.
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static void filterSample ( const samplingChannel* channel, float raw, float* output ) {
+
+    if( channel->samples == 0 ){                                    // First sample primes the filter
+        *output = raw;
+    }
+    else {
+        *output += ( raw - *output ) * channel->config.filterAlpha;
+    }
+}
+
+/*********************************************************************
+  * Function name: channelWeight
+  * Function inputs: const samplingChannel* channel
+  * Function outputs: the channel's period in units of its shortest
+  *                   period
+  * Function description: how many samples at the fastest rate the
+  *                       newest sample stands in for, so the windowed
+  *                       statistics stay averages over time while the
+  *                       rate adapts
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static unsigned int channelWeight ( const samplingChannel* channel ) {
+
+    return channel->period / channel->config.minPeriod;
+}
+
+/*********************************************************************
+  * Function name: adaptPeriod
+  * Function inputs: samplingChannel* channel, float raw
+  * Function outputs: void
+  * Function description: picks the channel's next period from how far
+  *                       raw is from the nearest alarm limit and how
+  *                       much it moves from one sample to the next.
+  *                       The period halves when the value could reach
+  *                       a limit within ADAPT_LOOKAHEAD samples and
+  *                       doubles once it could not do so even at twice
+  *                       the period, so it does not flip between two
+  *                       rates. Inside the guard band or past a limit
+  *                       the channel runs at its fastest rate. Only
+  *                       multiplies and compares, no divides.
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static void adaptPeriod ( samplingChannel* channel, float raw ) {
+
+    const channelConfig* config = &channel->config;
+    float distance;
+    float reach;
+
+    if( channel->samples == 0 ){                                    // Nothing to compare against yet
+        channel->previous = raw;
+        channel->change = 0;
+        return;
+    }
+    channel->change += ( fabs(raw - channel->previous) - channel->change ) * ADAPT_SMOOTHING;
+    channel->previous = raw;
+
+    if( config->lowLimit >= config->highLimit ){                    // No limits, nothing to adapt to
+        return;
+    }
+    distance = raw - config->lowLimit;
+    if( config->highLimit - raw < distance ){
+        distance = config->highLimit - raw;
+    }
+
+    reach = channel->change * ADAPT_LOOKAHEAD;                      // How far the value can move in the lookahead
+    if( distance <= config->guardBand ){
+        channel->period = config->minPeriod;
+    }
+    else if( reach >= distance ){
+        channel->period /= 2;
+    }
+    else if( reach * 4 < distance ){                                // Twice the period moves twice as far, with 2x margin
+        channel->period *= 2;
+    }
+
+    if( channel->period < config->minPeriod ){
+        channel->period = config->minPeriod;
+    }
+    else if( channel->period > config->maxPeriod ){
+        channel->period = config->maxPeriod;
+    }
+}
+
+/*********************************************************************
+  * Function name: sampleHvil
+  * Function inputs: measurementData* data, samplingChannel* channel
+  * Function outputs: the raw sample
+  * Function description: sampling job for the HVIL input pin
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static float sampleHvil ( measurementData* data, samplingChannel* channel ) {
+
+    (void) channel;
+    *data->hvilStatus = data->sensors->hvil(data->sensorContext);
+    return *data->hvilStatus;
+}
+
+/*********************************************************************
+  * Function name: sampleCurrent
+  * Function inputs: measurementData* data, samplingChannel* channel
+  * Function outputs: the raw sample
+  * Function description: sampling job for the HV current. The raw
+  *                       sample feeds the windowed statistics so
+  *                       peaks are not smoothed away, and the burst
+  *                       capture with the latest voltage and HVIL.
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static float sampleCurrent ( measurementData* data, samplingChannel* channel ) {
+
+    float raw = data->sensors->current(data->sensorContext);
+    updateWeightedStats(data->currentStats, raw, channelWeight(channel), millis());
+    filterSample(channel, raw, data->hvCurrent);
+    if( data->capture != NULL ){
+        recordCapture(data->capture, channel->lastSample, raw, *data->hvVoltage, *data->hvilStatus);
+    }
+    return raw;
+}
+
+/*********************************************************************
+  * Function name: sampleVoltage
+  * Function inputs: measurementData* data, samplingChannel* channel
+  * Function outputs: the raw sample
+  * Function description: sampling job for the HV voltage
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static float sampleVoltage ( measurementData* data, samplingChannel* channel ) {
+
+    float raw = data->sensors->voltage(data->sensorContext);
+    updateWeightedStats(data->voltageStats, raw, channelWeight(channel), millis());
+    filterSample(channel, raw, data->hvVoltage);
+    return raw;
+}
+
+/*********************************************************************
+  * Function name: sampleTemperature
+  * Function inputs: measurementData* data, samplingChannel* channel
+  * Function outputs: the raw sample
+  * Function description: sampling job for the pack temperature
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static float sampleTemperature ( measurementData* data, samplingChannel* channel ) {
+
+    float raw = data->sensors->temperature(data->sensorContext);
+    filterSample(channel, raw, data->temperature);
+    return raw;
+}
+
+/*********************************************************************
+  * Function name: sampleHistory
+  * Function inputs: measurementData* data, samplingChannel* channel
+  * Function outputs: 0, there is no raw sample
+  * Function description: records the latest filtered values in the
+  *                       trend history
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static float sampleHistory ( measurementData* data, samplingChannel* channel ) {
+
+    (void) channel;
+    pushHistory(data->history, *data->hvVoltage, *data->hvCurrent, *data->temperature);
+    return 0;
+}
+
+/* Sampling job of each channel, indexed by CHANNEL_* */
+static float (* const sampleJobs[MEASUREMENT_CHANNELS])(measurementData*, samplingChannel*) = {
+    sampleHvil, sampleCurrent, sampleVoltage, sampleTemperature, sampleHistory
+};
+
+/*********************************************************************
+  * Function name: sortChannels
+  * Function inputs: channelTable* table
+  * Function outputs: void
+  * Function description: orders the channel numbers by priority so
+  *                       measurementTask can walk them in order
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+static void sortChannels ( channelTable* table ) {
+
+    for( byte i = 0; i < MEASUREMENT_CHANNELS; i++ ){
+        table->order[i] = i;
+    }
+    for( byte i = 1; i < MEASUREMENT_CHANNELS; i++ ){               // Insertion sort, the table is tiny
+        byte channel = table->order[i];
+        byte j = i;
+        while( j > 0 && table->channel[table->order[j - 1]].config.priority > table->channel[channel].config.priority ){
+            table->order[j] = table->order[j - 1];
+            j--;
+        }
+        table->order[j] = channel;
+    }
+}
+
+/*********************************************************************
+  * Function name: initMeasurementChannels
+  * Function inputs: channelTable* table, unsigned long now
+  * Function outputs: void
+  * Function description: loads the default rate, priority and filter
+  *                       of every channel and makes all of them due
+  *                       at time now (micros)
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+void initMeasurementChannels ( channelTable* table, unsigned long now ) {
+
+    for( byte i = 0; i < MEASUREMENT_CHANNELS; i++ ){
+        table->channel[i].config  = defaultChannelConfig[i];
+        table->channel[i].nextDue = now;
+        table->channel[i].samples = 0;
+        table->channel[i].dropped = 0;
+        table->channel[i].lastSample = now;
+        table->channel[i].period  = defaultChannelConfig[i].period;
+        table->channel[i].previous = 0;
+        table->channel[i].change  = 0;
+    }
+    sortChannels(table);
+}
+
+/*********************************************************************
+  * Function name: setChannelConfig
+  * Function inputs: channelTable* table, byte channel,
+  *                  channelConfig config
+  * Function outputs: void
+  * Function description: replaces one channel's settings, the new
+  *                       period applies from its next sample and an
+  *                       adaptive channel adapts from there
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+void setChannelConfig ( channelTable* table, byte channel, channelConfig config ) {
+
+    table->channel[channel].config = config;
+    table->channel[channel].period = config.period;
+    sortChannels(table);
+}
+
+/*********************************************************************
+  * Function name: channelRate
+  * Function inputs: const channelTable* table, byte channel
+  * Function outputs: samples per second the channel runs at now
+  * Function description: the adaptive rate as a metric for the
+  *                       serial monitor and the host tools
+  * Author(s): Leonard Shin; Leika Yamada
+  ********************************************************************/
+unsigned long channelRate ( const channelTable* table, byte channel ) {
+
+    return 1000000UL / table->channel[channel].period;
+}
+
 /**********************************************************************
-  *  Function name: measurementTasks
+  *  Function name: measurementTask
   *  Function inputs: void* mData
   *  Function outputs: ~
-  *  Function description: modifies mData to represent
-  *                        the data at the current time point
+  *  Function description: runs the sampling job of every channel that
+  *                        is due, highest priority first. A channel
+  *                        that is not due costs one compare, so slow
+  *                        channels add nothing at fast call rates.
   *  Author(s): Leonard Shin; Leika Yamada
   *********************************************************************/
 void measurementTask ( void* mData ) {
     measurementData* data = (measurementData*) mData;
-  
-    // Update all sensors
-    updateHVIL(data->hvilStatus, data->hvilPin);
-    updateTemperature(data->temperature);
-    updateHvCurrent(data->hvCurrent);
-    updateHvVoltage(data->hvVoltage);
+    channelTable* table = data->channels;
+
+    for( byte i = 0; i < MEASUREMENT_CHANNELS; i++ ){
+        byte number = table->order[i];
+        samplingChannel* channel = &table->channel[number];
+        unsigned long now = micros();
+
+        if( (long) ( now - channel->nextDue ) < 0 ){                // Not due yet
+            continue;
+        }
+
+        channel->lastSample = now;                                  // Before the job, so it can stamp what it records
+        float raw = sampleJobs[number](data, channel);
+        if( channel->config.minPeriod < channel->config.maxPeriod ){
+            adaptPeriod(channel, raw);
+        }
+        channel->samples++;
+
+        channel->nextDue += channel->period;                        // Keep the rate exact, unless a whole period was missed
+        if( (long) ( now - channel->nextDue ) >= 0 ){
+            channel->dropped += ( now - channel->nextDue ) / channel->period + 1;
+            channel->nextDue = now + channel->period;
+        }
+    }
   
     return;
 }
@@ -8,22 +8,98 @@ extern "C" {
 
 #define HVIL_OPEN   false
 #define HVIL_CLOSED true
+#define HVIL_PIN    22      // Interlock loop input, read through gpioPin<HVIL_PIN>
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <Arduino.h>
+#include "Statistics.h"
+#include "History.h"
+#include "Capture.h"
 
 
+/* Sampling channels, each one is an independently scheduled job*/
+#define CHANNEL_HVIL            0
+#define CHANNEL_CURRENT         1
+#define CHANNEL_VOLTAGE         2
+#define CHANNEL_TEMPERATURE     3
+#define CHANNEL_HISTORY         4       // Records the filtered values for the trend screen
+#define MEASUREMENT_CHANNELS    5
+
+/* Default sample periods in microseconds*/
+#define HVIL_PERIOD             10000UL     // 100 Hz
+#define CURRENT_PERIOD          1000UL      // 1 kHz, fast enough for coulomb counting
+#define VOLTAGE_PERIOD          10000UL     // 100 Hz
+#define TEMPERATURE_PERIOD      1000000UL   // 1 Hz
+#define HISTORY_PERIOD          1000000UL   // 1 Hz, one trend plot line per second
+
+/* Adaptive rate bounds. Periods halve and double from the default, so the
+ * bounds are the default period times a power of two.*/
+#define CURRENT_MIN_PERIOD      500UL       // 2 kHz near a limit
+#define CURRENT_MAX_PERIOD      16000UL     // 62.5 Hz while steady
+#define VOLTAGE_MIN_PERIOD      2500UL      // 400 Hz near a limit
+#define VOLTAGE_MAX_PERIOD      80000UL     // 12.5 Hz while steady
+
+#define ADAPT_LOOKAHEAD         8           // Samples a channel should take before its value can reach a limit
+#define ADAPT_SMOOTHING         0.25        // Weight of a new sample to sample change in the rate of change estimate
+
+
+typedef struct samplingChannelConfig {    // Per channel sampling settings
+    unsigned long period;                 // Microseconds between samples, the starting period of an adaptive channel
+    byte priority;                        // 0 is the highest, higher priority channels run first when several are due
+    float filterAlpha;                    // First order low pass weight of a new sample, 1 leaves samples unfiltered
+    unsigned long minPeriod;              // Adaptive rate bounds, the rate is fixed when they are equal
+    unsigned long maxPeriod;
+    float lowLimit;                       // Alarm limits the rate adapts to, none when lowLimit >= highLimit
+    float highLimit;
+    float guardBand;                      // Closer than this to a limit the channel runs at minPeriod
+} channelConfig;
+
+typedef struct samplingChannel {          // Scheduling state of one channel
+    channelConfig config;
+    unsigned long nextDue;                // micros() value the next sample is due at
+    unsigned long samples;                // Samples taken since start up
+    unsigned long dropped;                // Samples skipped because the channel fell a whole period behind
+    unsigned long lastSample;             // micros() timestamp of the newest sample, carried to the alarm and display paths
+    unsigned long period;                 // Microseconds between samples right now
+    float previous;                       // Last raw sample
+    float change;                         // Smoothed absolute change from one sample to the next
+} samplingChannel;
+
+typedef struct samplingChannelTable {     // All channels plus the order they are checked in
+    samplingChannel channel[MEASUREMENT_CHANNELS];
+    byte order[MEASUREMENT_CHANNELS];     // Channel numbers sorted by priority
+} channelTable;
+
+typedef struct sensorSourceData {        // Where the raw readings of one pack come from
+    bool (*hvil)(void* context);          // Every function gets the sensorContext of the measurement data,
+    float (*current)(void* context);      //  so several packs can share one source
+    float (*voltage)(void* context);
+    float (*temperature)(void* context);
+} sensorSource;
+
 typedef struct measurementTaskData {      // Contains Measurement Data
     bool* hvilStatus;
-    const byte* hvilPin;
     float* temperature;
   	float* hvCurrent;
 	  float* hvVoltage;
+    channelStats* currentStats;         // 1 s, 10 s and 60 s windowed statistics of hvCurrent
+    channelStats* voltageStats;         // 1 s, 10 s and 60 s windowed statistics of hvVoltage
+    trendHistory* history;              // Samples kept for the trend screen
+    channelTable* channels;             // Sampling rate, priority and filter of every channel
+    byte* clockTick;                    // Seconds counter of this pack, drives the simulated sensors
+    const sensorSource* sensors;        // Raw readings, simulatedSensors on the lab board
+    void* sensorContext;                // Passed to every sensors function
+    captureBuffer* capture;             // Burst capture fed by every current sample, NULL for none
 } measurementData;
 
+extern const sensorSource simulatedSensors;     // HVIL pin and the timed lab values, sensorContext is the measurementData
+
 
-void measurementTask (void*);
+void initMeasurementChannels (channelTable* table, unsigned long now);          // Load default settings, first samples due at now
+void setChannelConfig (channelTable* table, byte channel, channelConfig config); // Change one channel's rate, priority or filter
+void measurementTask (void*);                                                   // Runs whichever channels are due, call as often as possible
+unsigned long channelRate (const channelTable* table, byte channel);            // Samples per second the channel is taking now
 
 
 #endif
@@ -0,0 +1,378 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "ModuleBus.h"
+#include "Arduino.h"
+
+/*****************************************************************
+  * Function name: busCrc8
+  * Function inputs: const byte* data, byte length
+  * Function outputs: byte
+  * Function description: CRC-8 with polynomial 0x07 over length
+  *                       bytes, used on requests and replies
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+byte busCrc8 ( const byte* data, byte length ) {
+
+    byte crc = 0;
+
+    for( byte i = 0; i < length; i++ ){
+        crc ^= data[i];
+        for( byte bit = 0; bit < 8; bit++ ){
+            crc = ( crc & 0x80 ) ? (byte) ( ( crc << 1 ) ^ 0x07 ) : (byte) ( crc << 1 );
+        }
+    }
+    return crc;
+}
+
+/*****************************************************************
+  * Function name: sendRequest
+  * Function inputs: moduleBus* bus, unsigned long now
+  * Function outputs: void
+  * Function description: asks the next module of the sweep for its
+  *                       readings and queues it as in flight
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void sendRequest ( moduleBus* bus, unsigned long now ) {
+
+    byte request[BUS_REQUEST_LENGTH] = { BUS_SOF_REQUEST, bus->nextAddress, BUS_CMD_READ, 0 };
+    byte slot = ( bus->flightHead + bus->flightCount ) % BUS_MAX_WINDOW;
+
+    request[BUS_REQUEST_LENGTH - 1] = busCrc8(request, BUS_REQUEST_LENGTH - 1);
+    bus->port->write(request, BUS_REQUEST_LENGTH);
+
+    bus->flightAddress[slot] = bus->nextAddress;
+    bus->flightSent[slot]    = now;
+    bus->flightCount++;
+    bus->nextAddress++;
+}
+
+/*****************************************************************
+  * Function name: popFlight
+  * Function inputs: moduleBus* bus
+  * Function outputs: void
+  * Function description: removes the oldest in flight request
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void popFlight ( moduleBus* bus ) {
+
+    bus->flightHead = ( bus->flightHead + 1 ) % BUS_MAX_WINDOW;
+    bus->flightCount--;
+}
+
+/*****************************************************************
+  * Function name: storeReply
+  * Function inputs: moduleBus* bus, unsigned long now
+  * Function outputs: void
+  * Function description: matches the received reply with the
+  *                       request FIFO and stores its readings.
+  *                       Requests ahead of it in the FIFO got no
+  *                       reply and are counted as timeouts.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void storeReply ( moduleBus* bus, unsigned long now ) {
+
+    byte address = bus->rx[1];
+    byte position;
+    moduleReading* module;
+
+    for( position = 0; position < bus->flightCount; position++ ){   // Find it, replies come back in request order
+        if( bus->flightAddress[( bus->flightHead + position ) % BUS_MAX_WINDOW] == address ){
+            break;
+        }
+    }
+    if( position == bus->flightCount ){
+        bus->unexpected++;
+        return;
+    }
+    while( position-- > 0 ){                                        // Skipped modules will not answer any more
+        bus->modules[bus->flightAddress[bus->flightHead]].timeouts++;
+        bus->modules[bus->flightAddress[bus->flightHead]].valid = false;
+        popFlight(bus);
+    }
+    popFlight(bus);
+
+    module = &bus->modules[address];
+    module->voltage     = ( bus->rx[2] | ( bus->rx[3] << 8 ) ) * 0.01;
+    module->minCell     = ( bus->rx[4] | ( bus->rx[5] << 8 ) ) * 0.001;
+    module->maxCell     = ( bus->rx[6] | ( bus->rx[7] << 8 ) ) * 0.001;
+    module->temperature = (signed char) bus->rx[8] * 0.5;
+    module->stamp       = now;
+    module->valid       = true;
+}
+
+/*****************************************************************
+  * Function name: resyncReply
+  * Function inputs: moduleBus* bus
+  * Function outputs: void
+  * Function description: drops the received bytes up to the next
+  *                       start byte after the first, so a reply
+  *                       that began inside a bad or cut short one
+  *                       is not lost with it
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void resyncReply ( moduleBus* bus ) {
+
+    byte from = 1;
+
+    while( from < bus->rxCount && bus->rx[from] != BUS_SOF_RESPONSE ){
+        from++;
+    }
+    for( byte i = from; i < bus->rxCount; i++ ){
+        bus->rx[i - from] = bus->rx[i];
+    }
+    bus->rxCount -= from;
+}
+
+/*****************************************************************
+  * Function name: receiveBytes
+  * Function inputs: moduleBus* bus, unsigned long now
+  * Function outputs: void
+  * Function description: reads whatever bytes have arrived,
+  *                       resynchronizing on the next start byte
+  *                       after noise or a bad CRC
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void receiveBytes ( moduleBus* bus, unsigned long now ) {
+
+    while( bus->port->available() > 0 ){
+        byte value = (byte) bus->port->read();
+
+        if( bus->rxCount == 0 && value != BUS_SOF_RESPONSE ){
+            continue;
+        }
+        bus->rx[bus->rxCount++] = value;
+        if( bus->rxCount < BUS_RESPONSE_LENGTH ){
+            continue;
+        }
+
+        if( busCrc8(bus->rx, BUS_RESPONSE_LENGTH - 1) != bus->rx[BUS_RESPONSE_LENGTH - 1] ||
+            bus->rx[1] >= bus->moduleCount ){
+            bus->crcErrors++;
+            resyncReply(bus);
+            continue;
+        }
+        bus->rxCount = 0;
+        storeReply(bus, now);
+    }
+}
+
+/*****************************************************************
+  * Function name: mergePack
+  * Function inputs: moduleBus* bus, unsigned long now
+  * Function outputs: void
+  * Function description: folds the module readings into the pack
+  *                       summary at the end of a sweep
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void mergePack ( moduleBus* bus, unsigned long now ) {
+
+    packSummary* pack = bus->pack;
+
+    pack->voltage        = 0;
+    pack->minCell        = 0;
+    pack->maxCell        = 0;
+    pack->maxTemperature = 0;
+    pack->validModules   = 0;
+
+    for( byte i = 0; i < bus->moduleCount; i++ ){
+        moduleReading* module = &bus->modules[i];
+        if( !module->valid ){
+            continue;
+        }
+        if( pack->validModules == 0 || module->minCell < pack->minCell ){
+            pack->minCell = module->minCell;
+        }
+        if( pack->validModules == 0 || module->maxCell > pack->maxCell ){
+            pack->maxCell = module->maxCell;
+        }
+        if( pack->validModules == 0 || module->temperature > pack->maxTemperature ){
+            pack->maxTemperature = module->temperature;
+        }
+        pack->voltage += module->voltage;
+        pack->validModules++;
+    }
+    pack->sweepTime = now - bus->sweepStart;
+    pack->sweeps++;
+}
+
+/*****************************************************************
+  * Function name: initModuleBus
+  * Function inputs: moduleBus* bus, moduleBusPort* port,
+  *                  moduleReading* modules, packSummary* pack,
+  *                  byte moduleCount, byte window,
+  *                  unsigned long now
+  * Function outputs: void
+  * Function description: sets up the master to poll moduleCount
+  *                       modules with up to window requests in
+  *                       flight, first sweep starting at now
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void initModuleBus ( moduleBus* bus, moduleBusPort* port, moduleReading* modules, packSummary* pack,
+                     byte moduleCount, byte window, unsigned long now ) {
+
+    bus->port        = port;
+    bus->modules     = modules;
+    bus->pack        = pack;
+    bus->moduleCount = ( moduleCount > MAX_MODULES ) ? MAX_MODULES : moduleCount;
+    bus->window      = ( window < 1 ) ? 1 : ( window > BUS_MAX_WINDOW ) ? BUS_MAX_WINDOW : window;
+    bus->nextAddress = 0;
+    bus->flightHead  = 0;
+    bus->flightCount = 0;
+    bus->rxCount     = 0;
+    bus->sweepStart  = now;
+    bus->crcErrors   = 0;
+    bus->unexpected  = 0;
+
+    for( byte i = 0; i < bus->moduleCount; i++ ){
+        modules[i].valid    = false;
+        modules[i].timeouts = 0;
+    }
+    pack->sweeps = 0;
+}
+
+/*****************************************************************
+  * Function name: moduleBusTask
+  * Function inputs: void* busData
+  * Function outputs: void
+  * Function description: reads any replies, drops requests that
+  *                       timed out, and tops the pipeline back up
+  *                       to the window. A sweep ends when every
+  *                       module was asked and answered or timed
+  *                       out; the pack is then merged and the next
+  *                       sweep starts at once. Never blocks.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void moduleBusTask ( void* busData ) {
+
+    moduleBus* bus = (moduleBus*) busData;
+    unsigned long now = micros();
+
+    receiveBytes(bus, now);
+
+    /* A reply half received when its request times out may be the next
+     * module's, so it is kept; if it is what is left of the lost one its
+     * CRC fails and the receiver resynchronizes.*/
+    while( bus->flightCount > 0 && now - bus->flightSent[bus->flightHead] > BUS_TIMEOUT ){
+        bus->modules[bus->flightAddress[bus->flightHead]].timeouts++;
+        bus->modules[bus->flightAddress[bus->flightHead]].valid = false;
+        popFlight(bus);
+    }
+
+    if( bus->nextAddress == bus->moduleCount && bus->flightCount == 0 ){
+        mergePack(bus, now);
+        bus->nextAddress = 0;
+        bus->sweepStart  = now;
+    }
+
+    while( bus->flightCount < bus->window && bus->nextAddress < bus->moduleCount ){
+        sendRequest(bus, now);
+    }
+}
+
+/*****************************************************************
+  * Function name: initModuleSensor
+  * Function inputs: moduleSensor* sensor, const packSummary* pack,
+  *                  byte moduleCount, const sensorSource* fallback,
+  *                  void* fallbackContext
+  * Function outputs: void
+  * Function description: sets up sensor to read pack, built of
+  *                       moduleCount modules, through moduleSensors
+  *                       and fallback until every module answered a
+  *                       sweep
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void initModuleSensor ( moduleSensor* sensor, const packSummary* pack, byte moduleCount,
+                        const sensorSource* fallback, void* fallbackContext ) {
+
+    sensor->pack            = pack;
+    sensor->moduleCount     = moduleCount;
+    sensor->fallback        = fallback;
+    sensor->fallbackContext = fallbackContext;
+    sensor->voltage         = 0;
+    sensor->temperature     = 0;
+    sensor->sweeps          = pack->sweeps;
+    sensor->complete        = false;
+    sensor->fault           = false;
+    sensor->faultSweeps     = 0;
+}
+
+/*****************************************************************
+  * Function name: followPack
+  * Function inputs: moduleSensor* sensor
+  * Function outputs: void
+  * Function description: looks at each sweep once it is merged. A
+  *                       sweep missing any module would read the
+  *                       pack low, so it sets the module
+  *                       communication fault and the values of the
+  *                       last sweep every module answered are kept.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void followPack ( moduleSensor* sensor ) {
+
+    const packSummary* pack = sensor->pack;
+
+    if( pack->sweeps == sensor->sweeps ){
+        return;
+    }
+    sensor->sweeps = pack->sweeps;
+    sensor->fault  = pack->validModules < sensor->moduleCount;
+    if( sensor->fault ){
+        sensor->faultSweeps++;
+        return;
+    }
+    sensor->voltage     = pack->voltage;
+    sensor->temperature = pack->maxTemperature;
+    sensor->complete    = true;
+}
+
+/*****************************************************************
+  * Function name: moduleHvil, moduleCurrent, moduleVoltage,
+  *                moduleTemperature
+  * Function inputs: void* context, a moduleSensor
+  * Function outputs: the reading
+  * Function description: sensor source of a pack with monitor
+  *                       modules. The pack voltage is the sum of
+  *                       the module voltages and the temperature
+  *                       the hottest module's, from the last sweep
+  *                       every module answered; the fallback source
+  *                       is only read until the first such sweep,
+  *                       never once a module drops out. The modules
+  *                       measure no HVIL or current.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+
+static bool moduleHvil ( void* context ) {
+
+    moduleSensor* sensor = (moduleSensor*) context;
+    return sensor->fallback->hvil(sensor->fallbackContext);
+}
+
+static float moduleCurrent ( void* context ) {
+
+    moduleSensor* sensor = (moduleSensor*) context;
+    return sensor->fallback->current(sensor->fallbackContext);
+}
+
+static float moduleVoltage ( void* context ) {
+
+    moduleSensor* sensor = (moduleSensor*) context;
+    followPack(sensor);
+    if( !sensor->complete ){
+        return sensor->fallback->voltage(sensor->fallbackContext);
+    }
+    return sensor->voltage;
+}
+
+static float moduleTemperature ( void* context ) {
+
+    moduleSensor* sensor = (moduleSensor*) context;
+    followPack(sensor);
+    if( !sensor->complete ){
+        return sensor->fallback->temperature(sensor->fallbackContext);
+    }
+    return sensor->temperature;
+}
+
+const sensorSource moduleSensors = {
+    moduleHvil, moduleCurrent, moduleVoltage, moduleTemperature
+};
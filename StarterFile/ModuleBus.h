@@ -0,0 +1,115 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MODULEBUS_H_
+#define MODULEBUS_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <Arduino.h>
+#include "Measurement.h"
+
+
+/* Request, master to module:  SOF_REQUEST, address, command, crc8
+ * Response, module to master: SOF_RESPONSE, address, module voltage (10 mV),
+ *                             min cell (mV), max cell (mV), temperature (0.5 C
+ *                             steps, signed), crc8. 16-bit fields are little
+ *                             endian and the crc8 (poly 0x07) covers every byte
+ *                             before it.
+ * Modules sit on a daisy chain and answer in the order they are asked, so the
+ * master can keep several requests in flight and match replies in order.
+ * That hides the turnaround of each request, but every reply still takes
+ * its wire time on the one return line, so a sweep grows linearly with the
+ * module count, about 0.87 ms per module at BUS_BAUD.*/
+#define BUS_SOF_REQUEST     0xA5
+#define BUS_SOF_RESPONSE    0x5A
+#define BUS_CMD_READ        0x01
+#define BUS_REQUEST_LENGTH  4
+#define BUS_RESPONSE_LENGTH 10
+
+#define BUS_BAUD            115200UL
+#define MAX_MODULES         32
+#define BUS_MAX_WINDOW      8           // Most requests that can be in flight at once
+#define BUS_TIMEOUT         20000UL     // Microseconds to wait for a reply before giving up on it
+
+
+typedef struct moduleBusPortData {      // Byte stream to the module chain, Serial1 on the board
+    int (*available)(void);
+    int (*read)(void);
+    void (*write)(const byte* data, byte length);
+} moduleBusPort;
+
+typedef struct moduleReadingData {      // Latest values from one module
+    float voltage;                      // Module voltage, volts
+    float minCell;                      // Lowest cell voltage, volts
+    float maxCell;                      // Highest cell voltage, volts
+    float temperature;                  // Module temperature, degrees C
+    unsigned long stamp;                // micros() when the reply arrived
+    unsigned int timeouts;              // Replies that never came
+    bool valid;                         // False until the first good reply, and after a timeout
+} moduleReading;
+
+typedef struct packSummaryData {        // Whole pack, merged at the end of every sweep
+    float voltage;                      // Sum of valid module voltages
+    float minCell;
+    float maxCell;
+    float maxTemperature;
+    byte validModules;
+    unsigned long sweepTime;            // Microseconds the last sweep of all modules took
+    unsigned long sweeps;
+} packSummary;
+
+typedef struct moduleBusTaskData {      // Master side state of the module chain
+    moduleBusPort* port;
+    moduleReading* modules;             // One entry per module address, 0 to moduleCount - 1
+    packSummary* pack;
+    byte moduleCount;
+    byte window;                        // Requests allowed in flight, 1 to BUS_MAX_WINDOW
+
+    byte nextAddress;                   // Next module to ask in the current sweep
+    byte flightAddress[BUS_MAX_WINDOW]; // FIFO of requests waiting for a reply
+    unsigned long flightSent[BUS_MAX_WINDOW];
+    byte flightHead;
+    byte flightCount;
+
+    byte rx[BUS_RESPONSE_LENGTH];       // Reply being received
+    byte rxCount;
+
+    unsigned long sweepStart;
+    unsigned long crcErrors;
+    unsigned long unexpected;           // Good replies from a module that was not at the front of the FIFO
+} moduleBus;
+
+typedef struct moduleSensorData {       // sensorContext of moduleSensors
+    const packSummary* pack;
+    byte moduleCount;                   // Modules the pack is built of
+    const sensorSource* fallback;       // Readings used until every module answered a sweep
+    void* fallbackContext;
+
+    float voltage;                      // Pack voltage and hottest module of the last sweep every
+    float temperature;                  //  module answered, held while one is missing
+    unsigned long sweeps;               // Sweeps of pack already looked at
+    bool complete;                      // Every module has answered a sweep
+    bool fault;                         // Module communication fault, the last sweep missed a module
+    unsigned long faultSweeps;          // Sweeps that missed a module
+} moduleSensor;
+
+
+void initModuleBus (moduleBus* bus, moduleBusPort* port, moduleReading* modules, packSummary* pack,
+                    byte moduleCount, byte window, unsigned long now);
+void moduleBusTask (void*);                                     // Non blocking, call every scheduler pass
+byte busCrc8 (const byte* data, byte length);                   // CRC used by both ends of the link
+void initModuleSensor (moduleSensor* sensor, const packSummary* pack, byte moduleCount,
+                       const sensorSource* fallback, void* fallbackContext);
+
+extern const sensorSource moduleSensors;    // Pack voltage and hottest module from the last complete sweep,
+                                            //  HVIL and current from the fallback, see moduleSensor.fault
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
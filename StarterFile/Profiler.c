@@ -0,0 +1,239 @@
+#if !defined(__AVR__)
+#define _GNU_SOURCE                         // REG_RIP in the host signal context
+#endif
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "Profiler.h"
+#include "Arduino.h"
+
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#else
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+
+profileHistogram profile;
+
+#if defined(__AVR__)
+
+/*****************************************************************
+  * Function name: TIMER4_COMPA_vect
+  * Function inputs: ~
+  * Function outputs: ~
+  * Function description: sampling interrupt. The ATmega2560 pushes
+  *                       a 3 byte return address, so after the five
+  *                       pushes below it sits at SP+6 (bits 21-16),
+  *                       SP+7 (bits 15-8) and SP+8 (bits 7-0) as a
+  *                       word address. Byte address >> 8 is word
+  *                       address >> 7, one shift of the low two
+  *                       bytes. Written in assembly so the cost is
+  *                       fixed: about 70 cycles with entry and reti,
+  *                       0.45% of the CPU at PROFILE_HZ.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+ISR(TIMER4_COMPA_vect, ISR_NAKED) {
+
+    asm volatile(
+        "push r24                   \n\t"
+        "in   r24, __SREG__         \n\t"
+        "push r24                   \n\t"
+        "push r25                   \n\t"
+        "push r30                   \n\t"
+        "push r31                   \n\t"
+        "in   r30, __SP_L__         \n\t"
+        "in   r31, __SP_H__         \n\t"
+        "ldd  r24, Z+6              \n\t"   // Return address bits 21-16
+        "ldd  r25, Z+7              \n\t"   // Bits 15-8
+        "tst  r24                   \n\t"
+        "brne 1f                    \n\t"   // Above 128 KB
+        "sbrc r25, 7                \n\t"
+        "rjmp 1f                    \n\t"   // Above 64 KB
+        "ldd  r24, Z+8              \n\t"   // Bits 7-0
+        "lsl  r24                   \n\t"   // r25 = word address bits 14-7, the bucket
+        "rol  r25                   \n\t"
+        "ldi  r30, lo8(%[count])    \n\t"
+        "ldi  r31, hi8(%[count])    \n\t"
+        "clr  r24                   \n\t"   // r1 is not known to be zero inside a naked ISR
+        "add  r30, r25              \n\t"   // Two bytes per bucket
+        "adc  r31, r24              \n\t"
+        "add  r30, r25              \n\t"
+        "adc  r31, r24              \n\t"
+        "ld   r24, Z                \n\t"
+        "ldd  r25, Z+1              \n\t"
+        "adiw r24, 1                \n\t"
+        "breq 2f                    \n\t"   // Saturated, keep 65535
+        "st   Z, r24                \n\t"
+        "std  Z+1, r25              \n\t"
+        "rjmp 2f                    \n\t"
+        "1:                         \n\t"
+        "lds  r24, %[outside]       \n\t"
+        "lds  r25, %[outside]+1     \n\t"
+        "adiw r24, 1                \n\t"
+        "breq 2f                    \n\t"
+        "sts  %[outside], r24       \n\t"
+        "sts  %[outside]+1, r25     \n\t"
+        "2:                         \n\t"
+        "pop  r31                   \n\t"
+        "pop  r30                   \n\t"
+        "pop  r25                   \n\t"
+        "pop  r24                   \n\t"
+        "out  __SREG__, r24         \n\t"
+        "pop  r24                   \n\t"
+        "reti                       \n\t"
+        :
+        : [count] "i" (&profile.count[0]), [outside] "i" (&profile.outside)
+    );
+}
+
+/*****************************************************************
+  * Function name: profilerStart, profilerStop
+  * Function inputs: void
+  * Function outputs: void
+  * Function description: run Timer4 in CTC mode at PROFILE_HZ and
+  *                       enable or disable its compare interrupt.
+  *                       Timer4 drives PWM on pins 6-8 only, which
+  *                       the sketch does not use.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void profilerStart ( void ) {
+
+    TCCR4A = 0;
+    TCCR4B = _BV(WGM42) | _BV(CS41);                                // CTC on OCR4A, clock / 8
+    OCR4A  = F_CPU / 8 / PROFILE_HZ - 1;
+    TCNT4  = 0;
+    TIFR4  = _BV(OCF4A);
+    TIMSK4 |= _BV(OCIE4A);
+}
+
+void profilerStop ( void ) {
+
+    TIMSK4 &= ~_BV(OCIE4A);
+}
+
+/* A 16 bit count read while the interrupt is updating it could be torn*/
+static uint16_t readCount ( volatile uint16_t* count ) {
+
+    uint16_t value;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        value = *count;
+    }
+    return value;
+}
+
+#else
+
+/* Host build: SIGPROF stands in for the timer, so host programs can be
+ * profiled and the report checked with Host/profsym.py. Addresses are
+ * counted from the start of the executable, which is what nm prints for
+ * a position independent one.*/
+extern const char __executable_start[];
+
+static void profileSignal ( int number, siginfo_t* info, void* context ) {
+
+    ucontext_t* interrupted = (ucontext_t*) context;
+    uintptr_t address;
+    (void) number;
+    (void) info;
+
+#if defined(__x86_64__)
+    address = interrupted->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+    address = interrupted->uc_mcontext.pc;
+#else
+    (void) interrupted;
+    address = 0;
+#endif
+    address -= (uintptr_t) __executable_start;
+    if( ( address >> PROFILE_BUCKET_SHIFT ) < PROFILE_BUCKETS ){
+        if( profile.count[address >> PROFILE_BUCKET_SHIFT] != 0xFFFF ){
+            profile.count[address >> PROFILE_BUCKET_SHIFT]++;
+        }
+    }
+    else if( profile.outside != 0xFFFF ){
+        profile.outside++;
+    }
+}
+
+void profilerStart ( void ) {
+
+    struct sigaction action;
+    struct itimerval timer;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = profileSignal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigaction(SIGPROF, &action, NULL);
+
+    timer.it_interval.tv_sec  = 0;
+    timer.it_interval.tv_usec = 1000000 / PROFILE_HZ;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+void profilerStop ( void ) {
+
+    struct itimerval timer;
+
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+static uint16_t readCount ( volatile uint16_t* count ) {
+
+    return *count;
+}
+
+#endif
+
+/*****************************************************************
+  * Function name: profilerClear
+  * Function inputs: void
+  * Function outputs: void
+  * Function description: zeroes the histogram, sampling carries on
+  *                       if it is running
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void profilerClear ( void ) {
+
+    for( unsigned int b = 0; b < PROFILE_BUCKETS; b++ ){
+        profile.count[b] = 0;
+    }
+    profile.outside = 0;
+}
+
+/*****************************************************************
+  * Function name: profileReport
+  * Function inputs: void (*emit)(const char* line)
+  * Function outputs: void
+  * Function description: writes the histogram as text, one call to
+  *                       emit per line: a header with the layout,
+  *                       one "bucket count" line in hex and decimal
+  *                       for every bucket with samples, then END.
+  *                       Empty buckets are skipped, so a dump is a
+  *                       few dozen lines at 9600 baud.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void profileReport ( void (*emit)(const char* line) ) {
+
+    char line[64];
+
+    snprintf(line, sizeof(line), "PROFILE buckets=%u shift=%u hz=%u outside=%u\n",
+             (unsigned int) PROFILE_BUCKETS, (unsigned int) PROFILE_BUCKET_SHIFT,
+             (unsigned int) PROFILE_HZ, (unsigned int) readCount(&profile.outside));
+    emit(line);
+    for( unsigned int b = 0; b < PROFILE_BUCKETS; b++ ){
+        uint16_t count = readCount(&profile.count[b]);
+        if( count != 0 ){
+            snprintf(line, sizeof(line), "%02x %u\n", b, (unsigned int) count);
+            emit(line);
+        }
+    }
+    emit("END\n");
+}
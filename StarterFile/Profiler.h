@@ -0,0 +1,44 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+
+/* Statistical profiler. A timer interrupt samples the address the program
+ * was interrupted at and counts it in a histogram of flash buckets, so the
+ * share of samples in a bucket is the share of CPU time spent in the code
+ * it covers. Host/profsym.py turns a dump into per function shares using
+ * the symbol table of the ELF. Code that runs with interrupts disabled,
+ * the other ISRs included, is never sampled.*/
+#define PROFILE_BUCKETS         256         // 512 bytes of counters
+#define PROFILE_BUCKET_SHIFT    8           // 256 flash bytes per bucket, so the buckets cover the first 64 KB
+#define PROFILE_HZ              997         // Prime, so sampling does not run in step with millis() or the task periods
+
+
+typedef struct profileHistogramData {       // Written by the sampling interrupt only
+    volatile uint16_t count[PROFILE_BUCKETS];   // Samples per bucket, saturates at 65535
+    volatile uint16_t outside;                  // Samples above the covered range, saturates at 65535
+} profileHistogram;
+
+extern profileHistogram profile;
+
+
+void profilerStart (void);                                  // Start sampling at PROFILE_HZ
+void profilerStop (void);                                   // Stop sampling, the counts are kept
+void profilerClear (void);                                  // Zero every count
+void profileReport (void (*emit)(const char* line));        // Dump the histogram as text lines for Host/profsym.py
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+#ifndef _PROTOTHREAD_H
+#define _PROTOTHREAD_H
+
+/* Stackless resumable tasks in the style of Adam Dunkels' protothreads.
+ * A protothread is a function that returns at every PT_YIELD and picks up
+ * after it on the next call, using only the two bytes in pt to remember
+ * where it was. The macros work unchanged in C and C++, on the AVR and on
+ * the host, so the same slicing code is used everywhere.
+ *
+ * Limitations that come from the switch statement underneath:
+ *  - local variables are not kept across a yield, keep loop counters and
+ *    other state in file scope or in the task data
+ *  - a protothread body cannot contain its own switch statement around a
+ *    yield*/
+
+typedef struct protothread {
+    unsigned short lc;                  // Line to resume at, 0 when the thread is not started or has ended
+} pt;
+
+#define PT_WAITING  0
+#define PT_YIELDED  1
+#define PT_ENDED    2
+
+#define PT_THREAD(nameArgs) char nameArgs
+
+#define PT_INIT(p)      ( (p)->lc = 0 )
+#define PT_RUNNING(p)   ( (p)->lc != 0 )
+
+#define PT_BEGIN(p)     { char ptYieldFlag = 1; (void) ptYieldFlag; switch( (p)->lc ) { case 0:
+
+#define PT_END(p)       } ptYieldFlag = 0; PT_INIT(p); return PT_ENDED; }
+
+/* Return now, continue after this line on the next call*/
+#define PT_YIELD(p)                                 \
+    do {                                            \
+        ptYieldFlag = 0;                            \
+        (p)->lc = __LINE__; case __LINE__:          \
+        if( ptYieldFlag == 0 ) {                    \
+            return PT_YIELDED;                      \
+        }                                           \
+    } while( 0 )
+
+/* Return on every call until condition is true*/
+#define PT_WAIT_UNTIL(p, condition)                 \
+    do {                                            \
+        (p)->lc = __LINE__; case __LINE__:          \
+        if( !(condition) ) {                        \
+            return PT_WAITING;                      \
+        }                                           \
+    } while( 0 )
+
+#define PT_WAIT_WHILE(p, condition) PT_WAIT_UNTIL((p), !(condition))
+
+/* Run a child protothread to completion, yielding whenever it yields*/
+#define PT_WAIT_THREAD(p, thread) PT_WAIT_WHILE((p), (thread) < PT_ENDED)
+
+#define PT_SPAWN(p, child, thread)                  \
+    do {                                            \
+        PT_INIT((child));                           \
+        PT_WAIT_THREAD((p), (thread));              \
+    } while( 0 )
+
+#endif    // _PROTOTHREAD_H
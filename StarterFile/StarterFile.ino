@@ -3,11 +3,20 @@
 #include <stdbool.h>
 
 #include "Measurement.h"
+#include "Statistics.h"
+#include "History.h"
+#include "Latency.h"
+#include "ModuleBus.h"
+#include "Profiler.h"
+#include "Telemetry.h"
+#include "Capture.h"
+#include "Diagnostics.h"
 #include "TaskControlBlock.h"
 #include "StateOfCharge.h"
 #include "Contactor.h"
 #include "Display.h"
 #include "Alarm.h"
+#include "Gpio.h"
 
 
 #include <pin_magic.h>
@@ -36,14 +45,21 @@
 #define MEASURE 0x00  // Used to keep track of which screen is displayed: Measurement screen
 #define ALARM 0x01    // Used to keep track of which screen is displayed: Alarm screen
 #define BATTERY 0x02  // Used to keep track of which screen is displayed: Battery screen
+#define TREND 0x03    // Used to keep track of which screen is displayed: Trend screen
+#define DIAGNOSTICS 0x04  // Used to keep track of which screen is displayed: Diagnostics screen
 
-#define SOC 0                   // Constant SOC value
+#define SOC FULL                // State of charge at start up
+#define MODULE_COUNT 8          // Slave monitor modules on the Serial1 chain
+#define MODULE_WINDOW 4         // Module requests kept in flight
                                 // Task Control Blocks
 TCB measurementTCB;             // Declare measurement TCB
 TCB stateOfChargeTCB;           // Declare state of charge TCB
 TCB contactorTCB;               // Declare contactor TCB
 TCB alarmTCB;                   // Declare alarm TCB
 TCB displayTCB;                 // Declare display TCB   [Display should be last task done each cycle]
+TCB moduleBusTCB;               // Declare module bus TCB, polls the slave modules every pass
+TCB telemetryTCB;               // Declare telemetry TCB, streams frames to the host every pass
+TCB captureTCB;                 // Declare capture TCB, stores a frozen burst capture a few bytes per pass
 
                                 // Measurement Data
 measurementData measure;        // Declare measurement data structure - defined in Measurement.h
@@ -51,13 +67,21 @@ float hvCurrent     = 0;        // Stores the measured current in the HVIL
 float hvVoltage     = 0;        // Stores the measured voltage in the HVIL
 float temperature   = 0;        // Stores the measured temperature of the system
 bool hVIL           = 0;        // Stores whether or not the HVIL is closed(1) or open(0)
-const byte hvilPin  = 22;       // Stores the input pin number for HVIL
+channelStats currentStats;      // Windowed min/max/mean/RMS of the HV current
+channelStats voltageStats;      // Windowed min/max/mean/RMS of the HV voltage
+trendHistory history;           // Recent voltage, current and temperature samples for the trend screen
+channelTable channels;          // Sampling rate, priority and filter of each measured channel
+captureBuffer capture;          // Current, voltage and HVIL around the last trip, kept in EEPROM
 
                                 // Alarm Data
 alarmData alarmStatus;          // Declare an Alarm data structure - defined in Alarm.h
 byte hVoltInterlock;            // Store the alarm status for the HVIL alarm
 byte overCurrent;               // Store the overcurretn alarm status
 byte hVoltOutofRange;           // Store alarm status for HV out of range
+unsigned long alarmStamp = 0;   // micros() when an alarm last changed state
+float currentTimeToLimit = TREND_NEVER;     // Seconds until the current trend crosses a limit
+float voltageTimeToLimit = TREND_NEVER;     // Seconds until the voltage trend crosses a limit
+bool alarmAcknowledge = 0;      // Flag is true when the alarm screen's ACK button was pushed, until the alarm task acts on it
 
                                 // State Of Charge Data
 stateOfChargeData chargeState;  // Declare charge state data structure
@@ -66,34 +90,58 @@ float stateOfCharge = SOC;
                                 // Contactor Data
 contactorData contactState;
 bool contactorState = 0;        
-int contactorLED = 53;          // Store the output pin for the contactor
 bool contactorLocal = contactorState; // initialize local to be same as state
 bool contactorAck;
+unsigned long contactorStamp = 0;     // micros() when contactorState was last commanded
+
+latencyTrace latency;                 // Sample age histograms for the alarm, contactor and display paths
+
+                                // Slave Module Data
+moduleBus moduleChain;                // Master side of the Serial1 module chain
+moduleReading modules[MODULE_COUNT];  // Latest readings of every slave module
+packSummary pack;                     // Module readings merged into whole pack values
+moduleSensor packSensors;             // Pack voltage and temperature from the modules, held and flagged while one is missing
+
+                                // Telemetry Data
+telemetryData telemetry;              // Frames to the host gateway on Serial
+telemetryQueue telemetryFrames;       // Frames waiting for room in the Serial transmit buffer
 
 
 displayData displayUpdates;                                     // Display Data structure
 Elegoo_TFTLCD tft(LCD_CS, LCD_CD, LCD_WR, LCD_RD, LCD_RESET);   // LCD touchscreen
 TouchScreen ts = TouchScreen(XP, YP, XM, YM, 300);              // Touch screen input object
+uint16_t lcdIdentifier = 0x9341;                                // LCD controller found at start up
 
 byte clockTick = 0;                                             // Keep track real time, seconds between 0 and 18
 
                                                                                            
-int taskNumber = 5;                                                                             
-TCB* tasks[5]  = {&measurementTCB, &stateOfChargeTCB, &contactorTCB, &alarmTCB, &displayTCB};   // Make an array of 5 TCB tasks
+int taskNumber = 4;                                                                             
+TCB* tasks[4]  = {&stateOfChargeTCB, &contactorTCB, &alarmTCB, &displayTCB};     // Make an array of the 4 once per second TCB tasks,
+                                                                                 //  measurement runs every pass and schedules its own channels
+TCB* allTasks[TASK_COUNT] = {&measurementTCB, &moduleBusTCB, &telemetryTCB,       // Every task, in the order the diagnostics screen lists them
+                             &captureTCB, &stateOfChargeTCB, &contactorTCB, &alarmTCB, &displayTCB};
+schedulerStats scheduler;                                                        // CPU idle share for the diagnostics screen
 
 
-Elegoo_GFX_Button buttons[3];                                 // Create an array of button objects for the display
-char buttonlabels[3][9]   = {"Measures", "Alarms", "Battery"};  
-uint16_t buttoncolors[3]  = {CYAN, CYAN, CYAN};
+Elegoo_GFX_Button buttons[5];                                 // Create an array of button objects for the display
+char buttonlabels[5][9]   = {"Measure", "Alarms", "Battery", "Trend", "Diag"};  
+uint16_t buttoncolors[5]  = {CYAN, CYAN, CYAN, CYAN, CYAN};
 bool measureButton = 0;                                      // Flag is true when the measuremnt screen button is pushed 
 bool batteryButton = 0;                                      // Flag is true when the battery screen button is pushed
 bool alarmButton = 0;                                        // Flag is true when the alarm screen button is pushed
-byte currentScreen = 0;                                      // Stores which screen the user is on, 0 for measurement, 1 for alarm, 2 for battery
+bool trendButton = 0;                                        // Flag is true when the trend screen button is pushed
+bool diagnosticsButton = 0;                                  // Flag is true when the diagnostics screen button is pushed
+byte currentScreen = 0;                                      // Stores which screen the user is on, 0 for measurement, 1 for alarm, 2 for battery, 3 for trend,
+                                                             //  4 for diagnostics
 
 /*Battery Screen buttons*/
 Elegoo_GFX_Button batteryButtons[2];                         // Creates an array of buttons for the battery ON, OFF buttons
 char batteryButtonLabels[2][4] = {"OFF", "ON"};
 
+/*Alarm Screen button*/
+Elegoo_GFX_Button alarmAckButton;                            // Acknowledges the active alarms
+char alarmAckLabel[4] = "ACK";
+
 unsigned long time_1 = 0;
 
 /***********************************************************************************************************************
@@ -106,18 +154,40 @@ unsigned long time_1 = 0;
   **********************************************************************************************************************/
 void loop() {
     while( 1 ){
+        unsigned long pass = micros();                                                                // Release of the tasks polled every pass
+        unsigned long now = runTask(&measurementTCB, pass, pass);                                     // Sample whichever channels are due
+        now = runTask(&moduleBusTCB, pass, now);                                                      // Collect module replies, keep requests in flight
+        now = runTask(&telemetryTCB, pass, now);                                                      // Queue and send telemetry frames without blocking
+        now = runTask(&captureTCB, pass, now);                                                        // Store a frozen capture without blocking
+        
         unsigned long time_2 = millis();                                                              // Measures task start time
 
         if(time_2 - time_1 > 1000){
           time_1 = time_2;
+          unsigned long release = now;
           for( int i = 0; i < taskNumber/* - 1*/; i++ )                                                           
           {
-            tasks[i]->task(tasks[i]->taskDataPtr);                                                              // Call all 5 tasks, measurement, SOC, contactor, alarm, display
+            now = runTask(tasks[i], release, now);                                                    // Call all 4 tasks, SOC, contactor, alarm, display
           }
         clockTick = ( clockTick + 1 ) % 18;                                                           // Get clock tick 0 - 18 to keep system in real time
+        closeTaskWindows(allTasks, TASK_COUNT, &scheduler, now);                                      // Per second task times and idle share for the diagnostics screen
+        }
+        else {
+          for( int i = 0; i < taskNumber; i++ )
+          {
+            if( PT_RUNNING(&tasks[i]->thread) ){
+              now = runTask(tasks[i], now, now);                                                      // Run the next slice of a task that yielded part way through
+            }
+          }
         }
         // tasks[4]->task(tasks[4]->taskDataPtr); 
-        /*serialMonitor();*/                                                                          // Uncomment this line for debugging
+        if( telemetryBetweenFrames(&telemetryFrames) ){                                               // Text shares Serial with telemetry, keep it out of a frame
+            /*serialMonitor();*/                                                                      // Uncomment this line for debugging
+            /*latencyMonitor();*/                                                                     // Uncomment this line to report response times
+            /*rateMonitor();*/                                                                        // Uncomment this line to report sampling rates
+            /*profileMonitor();*/                                                                     // Uncomment this line to dump the profile for Host/profsym.py
+            /*captureMonitor();*/                                                                     // Uncomment this line to dump and clear the stored burst capture
+        }
         //unsigned long time_2 = millis();                                                            // Measures task end time
         //unsigned long time_3 = 1000 - ( time_2 - time_1 );                                          // Calculates how much to sleep in millisec, for tasks to execute in 1 sec. intervals
         //delay(time_3);                                                         
@@ -136,7 +206,7 @@ void serialMonitor()
 {
   
       Serial.print("My State of Charge is: ");
-      Serial.println(SOC, DEC);
+      Serial.println(stateOfCharge, DEC);
       Serial.print("My clock is: ");
       Serial.print(clockTick, DEC);
       Serial.print("\n");
@@ -147,6 +217,8 @@ void serialMonitor()
       Serial.println(overCurrent, DEC);
       Serial.print("My HVOutofRange_alarm is: ");
       Serial.println(hVoltOutofRange, DEC);
+      Serial.print("My Module_fault is: ");
+      Serial.println(packSensors.fault, DEC);
 
       Serial.print("My Temperature is: ");
       Serial.println(temperature, DEC);
@@ -158,6 +230,195 @@ void serialMonitor()
       Serial.println(hVIL, DEC);
 }
 
+/******************************************************************************
+  * Function name:    printLatency
+  * Function inputs:  const char* name, const latencyHistogram* histogram
+  * Function outputs: void
+  * Function description: Prints one latency histogram as a line of counts
+  *                       per power of two bucket, followed by the median,
+  *                       99th percentile and worst age in microseconds.
+  * Author(s): Leonard Shin, Leika Yamada
+  ******************************************************************************/
+void printLatency(const char* name, const latencyHistogram* histogram)
+{
+      Serial.print(name);
+      Serial.print(" n=");
+      Serial.print(histogram->samples, DEC);
+      Serial.print(" p50<=");
+      Serial.print(latencyPercentile(histogram, 50), DEC);
+      Serial.print("us p99<=");
+      Serial.print(latencyPercentile(histogram, 99), DEC);
+      Serial.print("us max=");
+      Serial.print(histogram->maximum, DEC);
+      Serial.print("us [");
+      for( byte b = 0; b < LATENCY_BUCKETS; b++ ){
+          Serial.print(histogram->count[b], DEC);
+          Serial.print(b < LATENCY_BUCKETS - 1 ? " " : "]\n");
+      }
+}
+
+/******************************************************************************
+  * Function name:    latencyMonitor
+  * Function inputs:  void
+  * Function outputs: void
+  * Function description: Reports how old data is when it reaches each sink,
+  *                       from the sample timestamps carried through the alarm,
+  *                       contactor and display paths.
+  * Author(s): Leonard Shin, Leika Yamada
+  ******************************************************************************/
+void latencyMonitor()
+{
+      printLatency("sample-to-alarm", &latency.sampleToAlarm);
+      printLatency("alarm-to-pixel", &latency.alarmToPixel);
+      printLatency("sample-to-pixel", &latency.sampleToPixel);
+      printLatency("command-to-pin", &latency.commandToPin);
+}
+
+/******************************************************************************
+  * Function name:    rateMonitor
+  * Function inputs:  void
+  * Function outputs: void
+  * Function description: Reports the rate every measurement channel samples
+  *                       at right now, in samples per second, with its sample
+  *                       and dropped sample counts. Current and voltage speed
+  *                       up near their alarm limits and slow down when steady.
+  * Author(s): Leonard Shin, Leika Yamada
+  ******************************************************************************/
+void rateMonitor()
+{
+      const char* names[MEASUREMENT_CHANNELS] = {"hvil", "current", "voltage", "temperature", "history"};
+
+      for( byte i = 0; i < MEASUREMENT_CHANNELS; i++ ){
+          Serial.print(names[i]);
+          Serial.print(" rate=");
+          Serial.print(channelRate(&channels, i), DEC);
+          Serial.print("/s samples=");
+          Serial.print(channels.channel[i].samples, DEC);
+          Serial.print(" dropped=");
+          Serial.println(channels.channel[i].dropped, DEC);
+      }
+}
+
+/******************************************************************************
+  * Function name:    serialLine
+  * Function inputs:  const char* line
+  * Function outputs: void
+  * Function description: Prints one line of a report built by a C module.
+  * Author(s): Leonard Shin, Leika Yamada
+  ******************************************************************************/
+void serialLine(const char* line)
+{
+      Serial.print(line);
+}
+
+/******************************************************************************
+  * Function name:    profileMonitor
+  * Function inputs:  void
+  * Function outputs: void
+  * Function description: Dumps the sampling profiler histogram. Capture the
+  *                       serial output and run Host/profsym.py on it with
+  *                       the sketch's ELF to see the share of time spent in
+  *                       each function.
+  * Author(s): Leonard Shin, Leika Yamada
+  ******************************************************************************/
+void profileMonitor()
+{
+      profileReport(&serialLine);
+}
+
+/******************************************************************************
+  * Function name:    captureMonitor
+  * Function inputs:  void
+  * Function outputs: void
+  * Function description: Dumps the burst capture the EEPROM holds, if there is
+  *                       one, one line per sample oldest first, then clears it
+  *                       so the next trip is stored. Until then later trips
+  *                       are only counted as missed.
+  * Author(s): Leonard Shin, Leika Yamada
+  ******************************************************************************/
+void captureMonitor()
+{
+      captureHeader header;
+      captureSample sample;
+      unsigned int at = 0;
+
+      if( !eepromCaptureHeld() ){
+          return;
+      }
+      for( unsigned int i = 0; i < sizeof(header); i++ ){
+          ((byte*) &header)[i] = eepromCaptureByte(at++);
+      }
+      Serial.print("capture cause=");
+      Serial.print(header.cause, DEC);
+      Serial.print(" samples=");
+      Serial.print(header.samples, DEC);
+      Serial.print(" pre=");
+      Serial.print(header.pre, DEC);
+      Serial.print(" trigger=");
+      Serial.print(header.trigger, DEC);
+      Serial.print(" missed=");
+      Serial.println(capture.missed, DEC);
+
+      for( unsigned int s = 0; s < header.samples; s++ ){
+          for( unsigned int i = 0; i < sizeof(sample); i++ ){
+              ((byte*) &sample)[i] = eepromCaptureByte(at++);
+          }
+          Serial.print(sample.stamp & ~1UL, DEC);
+          Serial.print(" ");
+          Serial.print(sample.current / CAPTURE_CURRENT_SCALE, 2);
+          Serial.print(" ");
+          Serial.print(sample.voltage / CAPTURE_VOLTAGE_SCALE, 2);
+          Serial.print(" ");
+          Serial.println(sample.stamp & 1, DEC);
+      }
+      eepromCaptureClear();
+}
+
+
+/******************************************************************************
+  * Function name:    serial1Available, serial1Read, serial1Write
+  * Function inputs:  see moduleBusPort
+  * Function outputs: see moduleBusPort
+  * Function description: Connect the module bus driver to Serial1.
+  * Author(s): Leonard Shin, Leika Yamada
+  ******************************************************************************/
+int serial1Available()
+{
+      return Serial1.available();
+}
+
+int serial1Read()
+{
+      return Serial1.read();
+}
+
+void serial1Write(const byte* data, byte length)
+{
+      Serial1.write(data, length);
+}
+
+moduleBusPort serial1Port = {&serial1Available, &serial1Read, &serial1Write};
+
+
+/******************************************************************************
+  * Function name:    serialRoom, serialWrite
+  * Function inputs:  see telemetryPort
+  * Function outputs: see telemetryPort
+  * Function description: Connect the telemetry stream to Serial.
+  * Author(s): Leonard Shin, Leika Yamada
+  ******************************************************************************/
+int serialRoom()
+{
+      return Serial.availableForWrite();
+}
+
+void serialWrite(const byte* data, byte length)
+{
+      Serial.write(data, length);
+}
+
+telemetryPort serialPort = {&serialRoom, &serialWrite};
+
 
 /********************************************************************
   * Function name: setup
@@ -172,63 +433,138 @@ void setup() {
 
        
     /* Initialize Measurement & Sensors*/
-    measure = {&hVIL, &hvilPin, &temperature, &hvCurrent, &hvVoltage};  // Initailize measure data struct with data
+    initChannelStats(&currentStats, millis());                          // Start the 1 s, 10 s and 60 s windows empty
+    initChannelStats(&voltageStats, millis());
+    measure = {&hVIL, &temperature, &hvCurrent, &hvVoltage,   // Initailize measure data struct with data
+               &currentStats, &voltageStats, &history, &channels,
+               &clockTick, &moduleSensors, &packSensors,                // Module readings, lab board readings until
+               &capture};                                               //  every module answers, see ModuleBus.c
+    initModuleSensor(&packSensors, &pack, MODULE_COUNT, &simulatedSensors, &measure);
+    initCapture(&capture, &eepromStorage);                              // Arm the burst capture, captures go to EEPROM
+    initMeasurementChannels(&channels, micros());                       // Load default sampling rates, all channels due immediately
     measurementTCB.task = &measurementTask;                             // Store a pointer to the measurementTask update function in the TCB
     measurementTCB.taskDataPtr = &measure;                                            
     measurementTCB.next = NULL;
     measurementTCB.prev = NULL;
+    measurementTCB.name = "Measure";
+    measurementTCB.deadline = PASS_DEADLINE;
+    measurementTCB.polled = true;
 
    
     /*Initialize Display*/
-    displayUpdates = {&hvilPin, &contactorState, &contactorLED};        // Initialize display data struct with data    
+    displayUpdates = {&contactorState, &displayTCB.thread};            // Initialize display data struct with data
     displayTCB.task = &displayTask;                                     // Store a pointer to the displayTask update function in the TCB
     displayTCB.taskDataPtr = &displayUpdates;
     displayTCB.next = NULL;
     displayTCB.prev = NULL;
+    displayTCB.name = "Display";
+    displayTCB.deadline = TASK_DEADLINE;
+    displayTCB.polled = false;
+    PT_INIT(&displayTCB.thread);
 
  
     /*Initialize Touch Input*/
     measureButton = 1;                                                  // Initalize the measure button as pressed to start display with measure screen
     batteryButton = 0;                                                  // Battery button initialized as not pressed
     alarmButton = 0;                                                    // Alarm screen button initialized as not pressed
+    trendButton = 0;                                                    // Trend screen button initialized as not pressed
+    diagnosticsButton = 0;                                              // Diagnostics screen button initialized as not pressed
     currentScreen = MEASURE;                                            // Initialize start screen as measurement screen
 
     
     /*Initialize Contactor*/
     contactState = {&contactorState, &contactorLocal,                   // Initialize contactor data struct with contactor data
-                    &contactorAck, &contactorLED};                    
+                    &contactorAck,
+                    &contactorStamp, &latency};                    
     contactorTCB.task = &contactorTask;                                 // Store a pointer to the contactor task update function in the TCB                             
     contactorTCB.taskDataPtr = &contactState;
     contactorTCB.next = NULL;
     contactorTCB.prev = NULL;
+    contactorTCB.name = "Contactor";
+    contactorTCB.deadline = TASK_DEADLINE;
+    contactorTCB.polled = false;
 
 
     /*Initialize Alarm */
-    alarmStatus = {&hVoltInterlock, &overCurrent, &hVoltOutofRange};    // Initialize alarm data struct with alarm data
+    alarmStatus = {&hVoltInterlock, &overCurrent, &hVoltOutofRange,     // Initialize alarm data struct with alarm data
+                   &hVIL, &hvCurrent, &hvVoltage,                       //  and the measurements they are evaluated on
+                   &channels, &alarmStamp, &latency,
+                   &currentStats, &voltageStats,                        //  and the trends the pre-warnings are based on
+                   &currentTimeToLimit, &voltageTimeToLimit,
+                   &alarmAcknowledge};                                  //  and the alarm screen's acknowledgement
     alarmTCB.task = &alarmTask;                                         // Store a pointer to the alarm task update function in the TCB
     alarmTCB.taskDataPtr = &alarmStatus;
     alarmTCB.next = NULL;
     alarmTCB.prev = NULL;
+    alarmTCB.name = "Alarm";
+    alarmTCB.deadline = TASK_DEADLINE;
+    alarmTCB.polled = false;
 
     
     /*Initialize SOC*/
-    chargeState = {};                                               // Initialize state of charge data struct with state of charge boolean
+    chargeState = {&stateOfCharge, &currentStats, PACK_CAPACITY,        // Initialize state of charge data struct, counting from SOC
+                   micros()};
     stateOfChargeTCB.task = &stateOfChargeTask;                         // Store a pointer to the soc task update function in the TCB
     stateOfChargeTCB.taskDataPtr = &chargeState;
     stateOfChargeTCB.next = NULL;
     stateOfChargeTCB.prev = NULL;
+    stateOfChargeTCB.name = "Charge";
+    stateOfChargeTCB.deadline = TASK_DEADLINE;
+    stateOfChargeTCB.polled = false;
 
 
     /*Initailize input and output pins*/
-    pinMode(hvilPin, INPUT);
-    pinMode(contactorLED, OUTPUT);
+    gpioPin<HVIL_PIN>::input();                                         // Pin numbers are in Measurement.h and Contactor.h
+    gpioPin<CONTACTOR_PIN>::write(contactorLocal);                      // The contactor task only writes changes, start the pin in step
+    gpioPin<CONTACTOR_PIN>::output();
 
 
     /*Initialize serial communication*/
     Serial.begin(9600);
-    Serial1.begin(9600);
+    Serial1.begin(BUS_BAUD);
     Serial1.setTimeout(1000);
 
+
+    /*Start the sampling profiler, under half a percent of the CPU*/
+    profilerStart();
+
+
+    /*Initialize Slave Modules*/
+    initModuleBus(&moduleChain, &serial1Port, modules, &pack,           // Poll all modules on Serial1 with a few requests in flight
+                  MODULE_COUNT, MODULE_WINDOW, micros());
+    moduleBusTCB.task = &moduleBusTask;
+    moduleBusTCB.taskDataPtr = &moduleChain;
+    moduleBusTCB.next = NULL;
+    moduleBusTCB.prev = NULL;
+    moduleBusTCB.name = "Modules";
+    moduleBusTCB.deadline = PASS_DEADLINE;
+    moduleBusTCB.polled = true;
+
+
+    /*Initialize Telemetry*/
+    telemetry = {&hVIL, &hvCurrent, &hvVoltage, &temperature,           // Frames carry the measurements, alarms, contactor state and module fault
+                 &stateOfCharge, &hVoltInterlock, &overCurrent,
+                 &hVoltOutofRange, &contactorState, &packSensors.fault, &channels,
+                 &serialPort, &telemetryFrames, 0};
+    initTelemetry(&telemetry, micros());
+    telemetryTCB.task = &telemetryTask;
+    telemetryTCB.taskDataPtr = &telemetry;
+    telemetryTCB.next = NULL;
+    telemetryTCB.prev = NULL;
+    telemetryTCB.name = "Telemetry";
+    telemetryTCB.deadline = PASS_DEADLINE;
+    telemetryTCB.polled = true;
+
+
+    /*Initialize Burst Capture*/
+    captureTCB.task = &captureTask;
+    captureTCB.taskDataPtr = &capture;
+    captureTCB.next = NULL;
+    captureTCB.prev = NULL;
+    captureTCB.name = "Capture";
+    captureTCB.deadline = PASS_DEADLINE;
+    captureTCB.polled = true;
+
     /*Initialize the TFT LCD screen and prepare it for display*/
     /*Identifier finder from project 1d, given in class*/
     tft.reset();                                                                                             
@@ -262,17 +598,20 @@ void setup() {
     identifier=0x9341; 
     }
     
+    lcdIdentifier = identifier;                                         // Display needs the controller type for hardware scrolling
     tft.begin(identifier);
     tft.setRotation(2); 
     tft.fillScreen(BLACK);         
     
     unsigned long time_1 = millis();                                                                             
 
-   /*Create scroll buttons for measurement, alarm, and battery screens*/
-  for (uint8_t row=0; row<3; row++) {                                                         // Measures Screen Button button coordinates start from the center of the button
+   /*Create scroll buttons for measurement, alarm, battery, trend, and diagnostics screens*/
+  for (uint8_t row=0; row<5; row++) {                                                         // Measures Screen Button button coordinates start from the center of the button
       buttons[row].initButton(&tft, BUTTON1_SPACING_X + row*BUTTON2_SPACING_X, BUTTON_Y,
                  BUTTON_W, BUTTON_H, WHITE, buttoncolors[row], BLACK,
                  buttonlabels[row], BUTTON_TEXTSIZE); 
       buttons[row].drawButton();
   }
+
+    scheduler.windowStart = micros();                                   // First diagnostics window starts with the scheduler
 }
@@ -4,44 +4,45 @@
 
 /**********************************************************************
   * Function name: updateStateOfCharge
-  * Function inputs: float* theStateOfCharge
+  * Function inputs: float* theStateOfCharge, float current,
+  *                  float seconds, float capacity
   * Function outputs: ~
-  * Function description: places the current state of charge value in
-  *                       the provided parameter, theStateOfCharge.
-  *                       Currently just cycles between [0, 50, 100]
-  *                       every 3 seconds
+  * Function description: counts the charge current amps moved in
+  *                       the last seconds out of (positive) or into
+  *                       (negative) a pack of capacity amp hours,
+  *                       and keeps the result between EMPTY and FULL
   * Author(s): Leonard Shin, Leika Yamada
   **********************************************************************/
-//void updateStateOfCharge ( float* theStateOfCharge ) {
-    //extern byte clockTick;
-    //if(clockTick%3 == 0x0){
-    //    *theStateOfCharge = EMPTY;
-    //  } 
-    //  else if(clockTick%3 == 0x1){
-    //    *theStateOfCharge = HALF;
-    //  }
-    //  else {
-    //    *theStateOfCharge = FULL;
-    //  }
-//    return;
-//}
+void updateStateOfCharge ( float* theStateOfCharge, float current, float seconds, float capacity ) {
+
+    *theStateOfCharge -= current * seconds / ( capacity * 36.0 );     // Amp seconds to percent of capacity
+    if( *theStateOfCharge < EMPTY ){
+        *theStateOfCharge = EMPTY;
+    }
+    else if( *theStateOfCharge > FULL ){
+        *theStateOfCharge = FULL;
+    }
+    return;
+}
 
 /***********************************************************************
   * Function name: stateOfChargeTask
   * Function inputs: generic pointer to the updated state of charge data
   * Function outputs: ~
-  * Function description: This function calls an update to in order to
-  *                       update the state of charge. It cycles through
-  *                       the values 0, 50, and 100 at a 1 second rate.
+  * Function description: Coulomb counts the state of charge from the
+  *                       mean of the last second of current samples,
+  *                       so every 1 kHz sample counts, not just the one
+  *                       that happens to be current when the task runs.
   * Author(s): Leonard Shin, Leika Yamada
   **********************************************************************/
 void stateOfChargeTask ( void* socData ) {
   
-    //stateOfChargeData* data = (stateOfChargeData*) socData;
+    stateOfChargeData* data = (stateOfChargeData*) socData;
+    unsigned long now = micros();
     
-                                                                          // Update all sensors
-    //updateStateOfCharge(data->stateOfCharge);
-    // Purposefully left empty
+    updateStateOfCharge(data->stateOfCharge, statsMean(data->currentStats, STATS_WINDOW_1S),
+                        ( now - data->lastUpdate ) / 1000000.0, data->capacity);
+    data->lastUpdate = now;
     
   return;
 }
@@ -13,11 +13,17 @@ extern "C" {
 #include <stdlib.h>
 #include <stdbool.h>
 #include <Arduino.h>
+#include "Statistics.h"
+
+#define PACK_CAPACITY 40.0                  // Amp hours from FULL to EMPTY
 
 
 typedef struct stateOfChargeTaskData {      // Defines a data struct to hold the SOC
   
-    //float* stateOfCharge;
+    float* stateOfCharge;                   // Percent, counted from the pack current
+    channelStats* currentStats;             // Windowed HV current, positive current discharges the pack
+    float capacity;                         // Amp hours from FULL to EMPTY
+    unsigned long lastUpdate;               // micros() of the previous update
     
 } stateOfChargeData;
 
@@ -0,0 +1,494 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "Statistics.h"
+#include "Arduino.h"
+
+#define RING_SLOTS ( STATS_SLOTS - 1 )
+
+/* Window lengths in milliseconds, indexed by STATS_WINDOW_* */
+static const unsigned long windowLength[STATS_WINDOWS] = { 1000UL, 10000UL, 60000UL };
+
+/*****************************************************************
+  * Function name: clearSlot
+  * Function inputs: statsSlot* slot
+  * Function outputs: void
+  * Function description: empties a slot so that any sample will
+  *                       become its new minimum and maximum
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void clearSlot ( statsSlot* slot ) {
+
+    slot->minimum    = INFINITY;
+    slot->maximum    = -INFINITY;
+    slot->sum        = 0;
+    slot->sumSquares = 0;
+    slot->count      = 0;
+}
+
+/*****************************************************************
+  * Function name: clearWindow
+  * Function inputs: slidingWindow* window, unsigned long now
+  * Function outputs: void
+  * Function description: drops every sample in the window and
+  *                       starts a new open slot at time now
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void clearWindow ( slidingWindow* window, unsigned long now ) {
+
+    clearSlot(&window->open);
+    window->head       = 0;
+    window->filled     = 0;
+    window->minFront   = 0;
+    window->minCount   = 0;
+    window->maxFront   = 0;
+    window->maxCount   = 0;
+    window->sum        = 0;
+    window->sumSquares = 0;
+    window->count      = 0;
+    window->slotStart  = now;
+}
+
+/*****************************************************************
+  * Function name: resyncSums
+  * Function inputs: slidingWindow* window
+  * Function outputs: void
+  * Function description: recomputes the running sums from the
+  *                       completed slots. Called once per trip
+  *                       around the ring so float rounding from
+  *                       repeated add/subtract cannot build up.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void resyncSums ( slidingWindow* window ) {
+
+    window->sum        = 0;
+    window->sumSquares = 0;
+    window->count      = 0;
+    for( byte i = 0; i < window->filled; i++ ){
+        window->sum        += window->slots[i].sum;
+        window->sumSquares += window->slots[i].sumSquares;
+        window->count      += window->slots[i].count;
+    }
+}
+
+/*****************************************************************
+  * Function name: pushSlot
+  * Function inputs: slidingWindow* window
+  * Function outputs: void
+  * Function description: moves the open slot into the ring of
+  *                       completed slots, evicting the oldest one
+  *                       when the ring is full, and updates the
+  *                       running sums and min/max deques
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void pushSlot ( slidingWindow* window ) {
+
+    byte position;
+
+    if( window->filled == RING_SLOTS ){                             // Evict the oldest slot, it is always at the deque fronts if present
+        statsSlot* oldest = &window->slots[window->head];
+        window->sum        -= oldest->sum;
+        window->sumSquares -= oldest->sumSquares;
+        window->count      -= oldest->count;
+
+        if( window->minCount && window->minQueue[window->minFront] == window->head ){
+            window->minFront = ( window->minFront + 1 ) % RING_SLOTS;
+            window->minCount--;
+        }
+        if( window->maxCount && window->maxQueue[window->maxFront] == window->head ){
+            window->maxFront = ( window->maxFront + 1 ) % RING_SLOTS;
+            window->maxCount--;
+        }
+        position     = window->head;
+        window->head = ( window->head + 1 ) % RING_SLOTS;
+    }
+    else{
+        position = ( window->head + window->filled ) % RING_SLOTS;
+        window->filled++;
+    }
+
+    window->slots[position] = window->open;
+    window->sum        += window->open.sum;
+    window->sumSquares += window->open.sumSquares;
+    window->count      += window->open.count;
+    if( position == RING_SLOTS - 1 ){
+        resyncSums(window);
+    }
+                                                                    // Drop deque entries the new slot dominates, then append it
+    while( window->minCount &&
+           window->slots[window->minQueue[( window->minFront + window->minCount - 1 ) % RING_SLOTS]].minimum >= window->open.minimum ){
+        window->minCount--;
+    }
+    window->minQueue[( window->minFront + window->minCount ) % RING_SLOTS] = position;
+    window->minCount++;
+
+    while( window->maxCount &&
+           window->slots[window->maxQueue[( window->maxFront + window->maxCount - 1 ) % RING_SLOTS]].maximum <= window->open.maximum ){
+        window->maxCount--;
+    }
+    window->maxQueue[( window->maxFront + window->maxCount ) % RING_SLOTS] = position;
+    window->maxCount++;
+
+    clearSlot(&window->open);
+}
+
+/*****************************************************************
+  * Function name: updateWindow
+  * Function inputs: slidingWindow* window, float sample,
+  *                  unsigned int weight, unsigned long now
+  * Function outputs: void
+  * Function description: closes every slot that ended before now,
+  *                       then adds the sample to the open slot as
+  *                       weight samples
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void updateWindow ( slidingWindow* window, float sample, unsigned int weight, unsigned long now ) {
+
+    if( now - window->slotStart >= window->slotPeriod * STATS_SLOTS ){  // No samples for a whole window, nothing left to keep
+        clearWindow(window, now);
+    }
+    while( now - window->slotStart >= window->slotPeriod ){
+        pushSlot(window);
+        window->slotStart += window->slotPeriod;
+    }
+
+    if( sample < window->open.minimum ){
+        window->open.minimum = sample;
+    }
+    if( sample > window->open.maximum ){
+        window->open.maximum = sample;
+    }
+    window->open.sum        += sample * weight;
+    window->open.sumSquares += sample * sample * weight;
+    window->open.count      += weight;
+}
+
+/*****************************************************************
+  * Function name: clearTrend
+  * Function inputs: trendFit* trend, unsigned long now
+  * Function outputs: void
+  * Function description: drops every point of the trend and
+  *                       starts a new point at time now
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void clearTrend ( trendFit* trend, unsigned long now ) {
+
+    trend->head       = 0;
+    trend->filled     = 0;
+    trend->sumT       = 0;
+    trend->sumV       = 0;
+    trend->sumTT      = 0;
+    trend->sumTV      = 0;
+    trend->origin     = now;
+    trend->pointSum   = 0;
+    trend->pointCount = 0;
+    trend->pointStart = now;
+}
+
+/*****************************************************************
+  * Function name: trendSeconds
+  * Function inputs: const trendFit* trend, unsigned long stamp
+  * Function outputs: float, stamp in seconds after the origin
+  * Function description: time axis of the fit. Kept close to the
+  *                       points so t squared does not swamp the
+  *                       spread of the points in float.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static float trendSeconds ( const trendFit* trend, unsigned long stamp ) {
+
+    return ( stamp - trend->origin ) * 0.001f;
+}
+
+/*****************************************************************
+  * Function name: resyncTrend
+  * Function inputs: trendFit* trend
+  * Function outputs: void
+  * Function description: moves the origin up to the oldest point
+  *                       and recomputes the running sums from the
+  *                       ring. Called once per trip around the
+  *                       ring, like resyncSums.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void resyncTrend ( trendFit* trend ) {
+
+    trend->origin = trend->stamp[trend->head];
+    trend->sumT   = 0;
+    trend->sumV   = 0;
+    trend->sumTT  = 0;
+    trend->sumTV  = 0;
+    for( byte i = 0; i < trend->filled; i++ ){
+        float t = trendSeconds(trend, trend->stamp[i]);
+        trend->sumT  += t;
+        trend->sumV  += trend->value[i];
+        trend->sumTT += t * t;
+        trend->sumTV += t * trend->value[i];
+    }
+}
+
+/*****************************************************************
+  * Function name: pushPoint
+  * Function inputs: trendFit* trend, unsigned long stamp,
+  *                  float value
+  * Function outputs: void
+  * Function description: adds a point to the ring, evicting the
+  *                       oldest one when the ring is full, and
+  *                       updates the running sums
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void pushPoint ( trendFit* trend, unsigned long stamp, float value ) {
+
+    byte position;
+    float t;
+
+    if( trend->filled == TREND_POINTS ){                            // Take the oldest point out of the sums
+        t = trendSeconds(trend, trend->stamp[trend->head]);
+        trend->sumT  -= t;
+        trend->sumV  -= trend->value[trend->head];
+        trend->sumTT -= t * t;
+        trend->sumTV -= t * trend->value[trend->head];
+        position    = trend->head;
+        trend->head = ( trend->head + 1 ) % TREND_POINTS;
+    }
+    else{
+        position = ( trend->head + trend->filled ) % TREND_POINTS;
+        trend->filled++;
+    }
+
+    trend->stamp[position] = stamp;
+    trend->value[position] = value;
+    t = trendSeconds(trend, stamp);
+    trend->sumT  += t;
+    trend->sumV  += value;
+    trend->sumTT += t * t;
+    trend->sumTV += t * value;
+    if( position == TREND_POINTS - 1 ){
+        resyncTrend(trend);
+    }
+}
+
+/*****************************************************************
+  * Function name: updateTrend
+  * Function inputs: trendFit* trend, float sample,
+  *                  unsigned int weight, unsigned long now
+  * Function outputs: void
+  * Function description: closes the point being collected once its
+  *                       period is over, then adds the sample to
+  *                       the new point as weight samples. Periods
+  *                       without samples leave no point.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void updateTrend ( trendFit* trend, float sample, unsigned int weight, unsigned long now ) {
+
+    if( now - trend->pointStart >= TREND_POINT_PERIOD * TREND_POINTS ){  // No samples for the whole fit, nothing left to keep
+        clearTrend(trend, now);
+    }
+    else if( now - trend->pointStart >= TREND_POINT_PERIOD ){
+        if( trend->pointCount ){
+            pushPoint(trend, trend->pointStart + TREND_POINT_PERIOD / 2, trend->pointSum / trend->pointCount);
+        }
+        trend->pointStart += ( now - trend->pointStart ) / TREND_POINT_PERIOD * TREND_POINT_PERIOD;
+        trend->pointSum   = 0;
+        trend->pointCount = 0;
+    }
+
+    trend->pointSum   += sample * weight;
+    trend->pointCount += weight;
+}
+
+/*****************************************************************
+  * Function name: initChannelStats
+  * Function inputs: channelStats* stats, unsigned long now
+  * Function outputs: void
+  * Function description: sets up the 1 s, 10 s and 60 s windows
+  *                       and the trend of a channel with no samples
+  *                       in them
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void initChannelStats ( channelStats* stats, unsigned long now ) {
+
+    for( byte w = 0; w < STATS_WINDOWS; w++ ){
+        stats->window[w].slotPeriod = windowLength[w] / STATS_SLOTS;
+        clearWindow(&stats->window[w], now);
+    }
+    clearTrend(&stats->trend, now);
+}
+
+/*****************************************************************
+  * Function name: updateChannelStats
+  * Function inputs: channelStats* stats, float sample,
+  *                  unsigned long now
+  * Function outputs: void
+  * Function description: adds one sample to every window of the
+  *                       channel. Costs constant time per sample
+  *                       regardless of window length or rate.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void updateChannelStats ( channelStats* stats, float sample, unsigned long now ) {
+
+    updateWeightedStats(stats, sample, 1, now);
+}
+
+/*****************************************************************
+  * Function name: updateWeightedStats
+  * Function inputs: channelStats* stats, float sample,
+  *                  unsigned int weight, unsigned long now
+  * Function outputs: void
+  * Function description: adds one sample that stands for weight
+  *                       samples at the channel's fastest rate.
+  *                       A channel whose rate changes passes the
+  *                       time since its last sample in units of
+  *                       its shortest period, so the mean and rms
+  *                       stay averages over time, not over samples.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void updateWeightedStats ( channelStats* stats, float sample, unsigned int weight, unsigned long now ) {
+
+    for( byte w = 0; w < STATS_WINDOWS; w++ ){
+        updateWindow(&stats->window[w], sample, weight, now);
+    }
+    updateTrend(&stats->trend, sample, weight, now);
+}
+
+/*****************************************************************
+  * Function name: statsMin
+  * Function inputs: const channelStats* stats, byte window
+  * Function outputs: float
+  * Function description: returns the smallest sample in the window
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+float statsMin ( const channelStats* stats, byte window ) {
+
+    const slidingWindow* w = &stats->window[window];
+    float minimum = w->open.minimum;
+
+    if( w->minCount && w->slots[w->minQueue[w->minFront]].minimum < minimum ){
+        minimum = w->slots[w->minQueue[w->minFront]].minimum;
+    }
+    return ( statsCount(stats, window) ? minimum : 0 );
+}
+
+/*****************************************************************
+  * Function name: statsMax
+  * Function inputs: const channelStats* stats, byte window
+  * Function outputs: float
+  * Function description: returns the largest sample in the window
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+float statsMax ( const channelStats* stats, byte window ) {
+
+    const slidingWindow* w = &stats->window[window];
+    float maximum = w->open.maximum;
+
+    if( w->maxCount && w->slots[w->maxQueue[w->maxFront]].maximum > maximum ){
+        maximum = w->slots[w->maxQueue[w->maxFront]].maximum;
+    }
+    return ( statsCount(stats, window) ? maximum : 0 );
+}
+
+/*****************************************************************
+  * Function name: statsMean
+  * Function inputs: const channelStats* stats, byte window
+  * Function outputs: float
+  * Function description: returns the mean of the samples in the
+  *                       window
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+float statsMean ( const channelStats* stats, byte window ) {
+
+    const slidingWindow* w = &stats->window[window];
+    unsigned long count = statsCount(stats, window);
+
+    return ( count ? ( w->sum + w->open.sum ) / count : 0 );
+}
+
+/*****************************************************************
+  * Function name: statsRms
+  * Function inputs: const channelStats* stats, byte window
+  * Function outputs: float
+  * Function description: returns the root mean square of the
+  *                       samples in the window, the I^2t for the
+  *                       window is statsRms^2 times its length
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+float statsRms ( const channelStats* stats, byte window ) {
+
+    const slidingWindow* w = &stats->window[window];
+    unsigned long count = statsCount(stats, window);
+
+    return ( count ? sqrt(( w->sumSquares + w->open.sumSquares ) / count) : 0 );
+}
+
+/*****************************************************************
+  * Function name: statsCount
+  * Function inputs: const channelStats* stats, byte window
+  * Function outputs: unsigned long
+  * Function description: returns how many samples are currently
+  *                       inside the window, weighted samples
+  *                       counted by their weight
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+unsigned long statsCount ( const channelStats* stats, byte window ) {
+
+    return stats->window[window].count + stats->window[window].open.count;
+}
+
+/*****************************************************************
+  * Function name: statsSlope
+  * Function inputs: const channelStats* stats
+  * Function outputs: float
+  * Function description: returns the slope of the least squares
+  *                       line through the trend points, in units
+  *                       per second
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+float statsSlope ( const channelStats* stats ) {
+
+    const trendFit* trend = &stats->trend;
+    float n = trend->filled;
+    float spread = n * trend->sumTT - trend->sumT * trend->sumT;
+
+    if( trend->filled < TREND_MIN_POINTS || spread <= 0 ){
+        return 0;
+    }
+    return ( n * trend->sumTV - trend->sumT * trend->sumV ) / spread;
+}
+
+/*****************************************************************
+  * Function name: statsTimeToLimit
+  * Function inputs: const channelStats* stats, float low,
+  *                  float high
+  * Function outputs: float
+  * Function description: returns how many seconds the trend line
+  *                       takes to leave [low, high], counted from
+  *                       the end of the newest point. 0 if the line
+  *                       is already outside, TREND_NEVER if it is
+  *                       flat, heading back in or there are too few
+  *                       points to tell.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+float statsTimeToLimit ( const channelStats* stats, float low, float high ) {
+
+    const trendFit* trend = &stats->trend;
+    float slope = statsSlope(stats);
+    byte newest;
+    float t;
+    float fitted;
+
+    if( trend->filled < TREND_MIN_POINTS ){
+        return TREND_NEVER;
+    }
+    newest = ( trend->head + trend->filled - 1 ) % TREND_POINTS;
+    t = trendSeconds(trend, trend->stamp[newest] + TREND_POINT_PERIOD / 2);
+    fitted = trend->sumV / trend->filled + slope * ( t - trend->sumT / trend->filled );   // The line passes through the means
+
+    if( fitted < low || fitted > high ){
+        return 0;
+    }
+    if( slope > 0 ){
+        return ( high - fitted ) / slope;
+    }
+    if( slope < 0 ){
+        return ( low - fitted ) / slope;
+    }
+    return TREND_NEVER;
+}
@@ -0,0 +1,103 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef STATISTICS_H_
+#define STATISTICS_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <Arduino.h>
+
+
+/* Window lengths kept for every measured channel*/
+#define STATS_WINDOW_1S     0
+#define STATS_WINDOW_10S    1
+#define STATS_WINDOW_60S    2
+#define STATS_WINDOWS       3
+
+/* Every window is split into a fixed number of time slots, so memory per
+ * window is constant no matter how long the window is or how fast samples
+ * arrive. The window covers the completed slots plus the slot being filled.*/
+#define STATS_SLOTS         10
+
+/* Least squares trend of every measured channel, fitted to the means of the
+ * last TREND_POINTS periods of TREND_POINT_PERIOD so the window covers the
+ * same time whatever rate the channel samples at. A sample and a new point
+ * cost the same few operations however many points the window holds.*/
+#define TREND_POINTS        20
+#define TREND_POINT_PERIOD  1000UL      // Milliseconds, the fit covers TREND_POINTS times this
+#define TREND_MIN_POINTS    4           // Fewer points than this give no trend
+#define TREND_NEVER         INFINITY    // Time to a limit the trend is not heading for
+
+
+typedef struct statisticsSlot {         // Summary of all samples that fell into one time slot
+    float minimum;
+    float maximum;
+    float sum;
+    float sumSquares;
+    unsigned int count;
+} statsSlot;
+
+typedef struct slidingWindowStats {     // One sliding window over a channel
+    statsSlot slots[STATS_SLOTS - 1];   // Completed slots, ring buffer ordered oldest to newest from head
+    statsSlot open;                     // Slot that is currently collecting samples
+    byte head;                          // Index of the oldest completed slot
+    byte filled;                        // Number of completed slots in the ring
+
+    byte minQueue[STATS_SLOTS - 1];     // Monotonic deques of slot indices: minQueue holds increasing minima,
+    byte maxQueue[STATS_SLOTS - 1];     //  maxQueue holds decreasing maxima, front is the window extreme
+    byte minFront, minCount;
+    byte maxFront, maxCount;
+
+    float sum;                          // Running sums over the completed slots
+    float sumSquares;
+    unsigned long count;
+
+    unsigned long slotPeriod;           // Slot length in milliseconds
+    unsigned long slotStart;            // millis() value the open slot started at
+} slidingWindow;
+
+typedef struct leastSquaresTrend {      // Straight line fit over the last TREND_POINTS points of a channel
+    unsigned long stamp[TREND_POINTS];  // millis() at the middle of each point, ring ordered oldest to newest from head
+    float value[TREND_POINTS];          // Mean of the samples of each point
+    byte head;                          // Index of the oldest point
+    byte filled;                        // Number of points in the ring
+
+    float sumT;                         // Running sums over the ring, t in seconds after origin
+    float sumV;
+    float sumTT;
+    float sumTV;
+    unsigned long origin;               // millis() of t = 0, moved up to the oldest point once per trip around the ring
+
+    float pointSum;                     // Point being collected, weighted as the windows are
+    unsigned int pointCount;
+    unsigned long pointStart;           // millis() value the point started at
+} trendFit;
+
+typedef struct channelStatistics {      // 1 s, 10 s and 60 s windows and the trend of one measured channel
+    slidingWindow window[STATS_WINDOWS];
+    trendFit trend;
+} channelStats;
+
+
+void initChannelStats (channelStats* stats, unsigned long now);                 // Clear all windows, start the first slot at now
+void updateChannelStats (channelStats* stats, float sample, unsigned long now); // Add one sample taken at time now (ms)
+void updateWeightedStats (channelStats* stats, float sample, unsigned int weight, unsigned long now);  // Add one sample counted weight times
+
+float statsMin (const channelStats* stats, byte window);                        // Window minimum, 0 if the window is empty
+float statsMax (const channelStats* stats, byte window);                        // Window maximum, 0 if the window is empty
+float statsMean (const channelStats* stats, byte window);                       // Window mean, 0 if the window is empty
+float statsRms (const channelStats* stats, byte window);                        // Window root mean square, 0 if the window is empty
+unsigned long statsCount (const channelStats* stats, byte window);              // Number of samples in the window, by weight
+float statsSlope (const channelStats* stats);                                   // Trend in units per second, 0 without enough points
+float statsTimeToLimit (const channelStats* stats, float low, float high);      // Seconds until the trend leaves [low, high], 0 if it is
+                                                                                //  outside, TREND_NEVER if it is not heading out
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
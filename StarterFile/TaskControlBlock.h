@@ -2,6 +2,22 @@
 #define _TASKCONTROLBLOCK_H
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include "Protothread.h"
+
+/* Run time accounting of one task, kept by runTask() in Diagnostics.c.
+ * Times are in microseconds; a window is the second between two calls of
+ * closeTaskWindows()*/
+typedef struct taskStatsData {
+    unsigned long runs;             // Runs in the current window
+    unsigned long time;             // Time run in the current window
+    unsigned long work;             // Part of time spent on actual work, see polled
+    unsigned int longest;           // Longest run in the current window
+    unsigned int fastest;           // Shortest run since start up, a poll with nothing to do
+    unsigned int average;           // Mean run of the last complete window
+    unsigned int worst;             // Longest run of the last complete window
+    unsigned int misses;            // Runs that ended after their deadline, since start up
+} taskStats;
 
 /* This struct represents a task control block (TCB)  
  *TCB encapsulates task function and data
@@ -11,6 +27,13 @@ typedef struct taskControlBlock {
     void* taskDataPtr;
     struct taskControlBlock* next;
     struct taskControlBlock* prev;
+    pt thread;                      // Resume point of a task that draws in slices, the scheduler keeps
+                                    //  calling a task every pass while PT_RUNNING(&thread)
+    const char* name;               // Shown on the diagnostics screen
+    unsigned long deadline;         // A run must end this many microseconds after its release
+    bool polled;                    // Called every pass whether or not it has work, its fastest run
+                                    //  counts as idle time
+    taskStats stats;
 } TCB;
 
 #endif    // _TASKCONTROLBLOCK_H
@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "Telemetry.h"
+#include "Arduino.h"
+
+/*****************************************************************
+  * Function name: telemetryCrc
+  * Function inputs: const byte* data, byte length
+  * Function outputs: unsigned int
+  * Function description: CRC-16 CCITT (poly 0x1021, init 0xFFFF)
+  *                       over length bytes
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+unsigned int telemetryCrc ( const byte* data, byte length ) {
+
+    uint16_t crc = 0xFFFF;
+
+    for( byte i = 0; i < length; i++ ){
+        crc ^= (uint16_t) data[i] << 8;
+        for( byte bit = 0; bit < 8; bit++ ){
+            crc = ( crc & 0x8000 ) ? (uint16_t) ( ( crc << 1 ) ^ 0x1021 ) : (uint16_t) ( crc << 1 );
+        }
+    }
+    return crc;
+}
+
+/*****************************************************************
+  * Function name: putLong, putFloat
+  * Function inputs: byte* at, the value
+  * Function outputs: void
+  * Function description: store a field little endian, whatever
+  *                       the byte order of the machine building
+  *                       the frame
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void putLong ( byte* at, uint32_t value ) {
+
+    at[0] = value;
+    at[1] = value >> 8;
+    at[2] = value >> 16;
+    at[3] = value >> 24;
+}
+
+static void putFloat ( byte* at, float value ) {
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putLong(at, bits);
+}
+
+/*****************************************************************
+  * Function name: buildTelemetryFrame
+  * Function inputs: byte* frame, the frame fields
+  * Function outputs: void
+  * Function description: lays out one complete frame, crc included,
+  *                       in TELEMETRY_FRAME_LENGTH bytes at frame
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void buildTelemetryFrame ( byte* frame, byte sequence, unsigned long stamp, float current, float voltage,
+                           float temperature, float stateOfCharge, byte status, byte faults ) {
+
+    unsigned int crc;
+
+    frame[0] = TELEMETRY_SOF1;
+    frame[1] = TELEMETRY_SOF2;
+    frame[TELEMETRY_AT_VERSION]  = TELEMETRY_VERSION;
+    frame[TELEMETRY_AT_SEQUENCE] = sequence;
+    putLong(&frame[TELEMETRY_AT_STAMP], stamp);
+    putFloat(&frame[TELEMETRY_AT_CURRENT], current);
+    putFloat(&frame[TELEMETRY_AT_VOLTAGE], voltage);
+    putFloat(&frame[TELEMETRY_AT_TEMP], temperature);
+    putFloat(&frame[TELEMETRY_AT_SOC], stateOfCharge);
+    frame[TELEMETRY_AT_STATUS] = status;
+    frame[TELEMETRY_AT_FAULTS] = faults;
+
+    crc = telemetryCrc(&frame[TELEMETRY_AT_VERSION], TELEMETRY_AT_CRC - TELEMETRY_AT_VERSION);
+    frame[TELEMETRY_AT_CRC]     = crc;
+    frame[TELEMETRY_AT_CRC + 1] = crc >> 8;
+}
+
+/*****************************************************************
+  * Function name: initTelemetry
+  * Function inputs: telemetryData* data, unsigned long now
+  * Function outputs: void
+  * Function description: empties the queue, the first frame is
+  *                       built at time now (micros)
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+void initTelemetry ( telemetryData* data, unsigned long now ) {
+
+    memset(data->queue, 0, sizeof(telemetryQueue));
+    data->nextDue = now;
+}
+
+/*****************************************************************
+  * Function name: queueFrame
+  * Function inputs: telemetryData* data
+  * Function outputs: void
+  * Function description: builds a frame from the current values at
+  *                       the back of the queue. With the queue full
+  *                       the new frame is dropped, so the host sees
+  *                       a gap in the sequence numbers rather than
+  *                       a frame cut short.
+  * Author(s): Leonard Shin; Leika Yamada
+  *****************************************************************/
+static void queueFrame ( telemetryData* data ) {
+
+    telemetryQueue* queue = data->queue;
+    byte status;
+
+    if( queue->count == TELEMETRY_QUEUE ){
+        queue->dropped++;
+        queue->sequence++;
+        return;
+    }
+    status = ( *data->hvilStatus ? 0x01 : 0 ) | ( *data->contactorState ? 0x02 : 0 ) |
+             ( ( *data->hVoltInterlock & 0x03 ) << 2 ) | ( ( *data->overCurrent & 0x03 ) << 4 ) |
+             ( ( *data->hVoltOutofRange & 0x03 ) << 6 );
+    buildTelemetryFrame(queue->frames[( queue->head + queue->count ) % TELEMETRY_QUEUE], queue->sequence++,
+                        data->channels->channel[CHANNEL_CURRENT].lastSample, *data->hvCurrent, *data->hvVoltage,
+                        *data->temperature, *data->stateOfCharge, status,
+                        *data->moduleFault ? TELEMETRY_FAULT_MODULES : 0);
+    queue->count++;
+    if( queue->count > queue->deepest ){
+        queue->deepest = queue->count;
+    }
+}
+
+/**********************************************************************
+  *  Function name: telemetryBetweenFrames
+  *  Function inputs: const telemetryQueue* queue
+  *  Function outputs: bool
+  *  Function description: true while every frame written to the port
+  *                        was written whole, so other output on the
+  *                        port cannot land inside one
+  *  Author(s): Leonard Shin; Leika Yamada
+  *********************************************************************/
+bool telemetryBetweenFrames ( const telemetryQueue* queue ) {
+    return queue->sent == 0;
+}
+
+/**********************************************************************
+  *  Function name: telemetryTask
+  *  Function inputs: void* tData
+  *  Function outputs: ~
+  *  Function description: queues a frame every TELEMETRY_PERIOD and
+  *                        writes as much of the queue as the port can
+  *                        take without blocking, so a slow link never
+  *                        holds up the scheduler.
+  *  Author(s): Leonard Shin; Leika Yamada
+  *********************************************************************/
+void telemetryTask ( void* tData ) {
+    telemetryData* data = (telemetryData*) tData;
+    telemetryQueue* queue = data->queue;
+    unsigned long now = micros();
+    int room;
+
+    if( (long) ( now - data->nextDue ) >= 0 ){
+        queueFrame(data);
+        data->nextDue += TELEMETRY_PERIOD;
+        if( (long) ( now - data->nextDue ) >= 0 ){                  // Fell a whole period behind, do not catch up in a burst
+            data->nextDue = now + TELEMETRY_PERIOD;
+        }
+    }
+
+    room = data->port->room();
+    while( queue->count > 0 && room > 0 ){
+        byte length = TELEMETRY_FRAME_LENGTH - queue->sent;
+        if( length > room ){
+            length = room;
+        }
+        data->port->write(&queue->frames[queue->head][queue->sent], length);
+        queue->sent += length;
+        room -= length;
+        if( queue->sent == TELEMETRY_FRAME_LENGTH ){
+            queue->head = ( queue->head + 1 ) % TELEMETRY_QUEUE;
+            queue->count--;
+            queue->sent = 0;
+        }
+    }
+
+    return;
+}
@@ -0,0 +1,99 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <Arduino.h>
+#include "Measurement.h"
+
+
+/* Telemetry frame, unit to host, TELEMETRY_FRAME_LENGTH bytes:
+ *   SOF1, SOF2, version, sequence, stamp (micros() of the newest current
+ *   sample, 32 bit), current, voltage, temperature, state of charge (IEEE
+ *   float), status, faults, crc16.
+ * Multi byte fields are little endian, the AVR's own layout. status holds
+ * the HVIL input in bit 0, the contactor in bit 1 and the HVIL, over
+ * current and HV range alarm states (NOT_ACTIVE to PRE_WARNING of Alarm.h)
+ * in bits 2-3, 4-5 and 6-7. faults holds the TELEMETRY_FAULT_* bits. The
+ * crc16 (CCITT, poly 0x1021, init 0xFFFF)
+ * covers every byte from version up to it. Two start bytes and the crc
+ * let the host find frame boundaries in the middle of a stream.*/
+#define TELEMETRY_SOF1          0xAA
+#define TELEMETRY_SOF2          0x55
+#define TELEMETRY_VERSION       2
+
+#define TELEMETRY_AT_VERSION    2           // Byte offsets in the frame
+#define TELEMETRY_AT_SEQUENCE   3
+#define TELEMETRY_AT_STAMP      4
+#define TELEMETRY_AT_CURRENT    8
+#define TELEMETRY_AT_VOLTAGE    12
+#define TELEMETRY_AT_TEMP       16
+#define TELEMETRY_AT_SOC        20
+#define TELEMETRY_AT_STATUS     24
+#define TELEMETRY_AT_FAULTS     25
+#define TELEMETRY_AT_CRC        26
+#define TELEMETRY_FRAME_LENGTH  28
+
+#define TELEMETRY_FAULT_MODULES 0x01        // A module missed the last sweep, pack voltage and temperature are held
+
+/* The text monitors of the sketch (serialMonitor, latencyMonitor, ...)
+ * share Serial with the frames and print with blocking Serial.print. They
+ * only run while telemetryBetweenFrames() is true, so their text goes in
+ * between whole frames; a frame split by text would be lost. Text is
+ * ASCII and never holds TELEMETRY_SOF1, so the host skips it and stays in
+ * step, at the cost of the link time the text takes.*/
+#define TELEMETRY_PERIOD        100000UL    // Microseconds between frames, 10 Hz is 280 of the 960 bytes/s at 9600 baud
+#define TELEMETRY_QUEUE         4           // Frames waiting for room in the serial transmit buffer
+
+
+typedef struct telemetryPortData {      // Byte stream to the host, Serial on the board
+    int (*room)(void);                  // Bytes that can be written without blocking
+    void (*write)(const byte* data, byte length);
+} telemetryPort;
+
+typedef struct telemetryQueueData {     // Frames built but not yet sent
+    byte frames[TELEMETRY_QUEUE][TELEMETRY_FRAME_LENGTH];
+    byte head;                          // Oldest frame
+    byte count;
+    byte sent;                          // Bytes of the oldest frame already written
+    byte deepest;                       // Most frames ever waiting at once
+    byte sequence;                      // Sequence number of the next frame
+    unsigned int dropped;               // Frames lost because the queue was full
+} telemetryQueue;
+
+typedef struct telemetryTaskData {
+    const bool* hvilStatus;             // Values sent in every frame
+    const float* hvCurrent;
+    const float* hvVoltage;
+    const float* temperature;
+    const float* stateOfCharge;
+    const byte* hVoltInterlock;
+    const byte* overCurrent;
+    const byte* hVoltOutofRange;
+    const bool* contactorState;
+    const bool* moduleFault;            // Module communication fault, see moduleSensor
+    const channelTable* channels;       // Sample time of the current the frame carries
+    telemetryPort* port;
+    telemetryQueue* queue;
+    unsigned long nextDue;              // micros() the next frame is built at
+} telemetryData;
+
+
+void initTelemetry (telemetryData* data, unsigned long now);
+void telemetryTask (void*);                                     // Non blocking, call every scheduler pass
+bool telemetryBetweenFrames (const telemetryQueue* queue);      // No frame is part way written to the port
+unsigned int telemetryCrc (const byte* data, byte length);      // CRC used by both ends of the link
+void buildTelemetryFrame (byte* frame, byte sequence, unsigned long stamp, float current, float voltage,
+                          float temperature, float stateOfCharge, byte status, byte faults);
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
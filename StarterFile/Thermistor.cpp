@@ -0,0 +1,42 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <Arduino.h>
+#include "Thermistor.h"
+
+/* The pack thermistor. A sensor sold with Steinhart-Hart coefficients
+ * instead of a beta is thermistorSteinhartHart(a, b, c, THERMISTOR_SERIES).*/
+constexpr thermistorModel packThermistor =
+    thermistorBeta(THERMISTOR_R0, THERMISTOR_T0, THERMISTOR_BETA, THERMISTOR_SERIES);
+
+/* Built by the compiler; copying the constexpr table keeps any of it from
+ * being worked out by a constructor at start up*/
+constexpr thermistorTable packCurve = makeThermistorTable(packThermistor);
+static_assert(packCurve.centi[THERMISTOR_SEGMENTS / 2] == 2500, "mid scale of the divider is not THERMISTOR_T0");
+
+const thermistorTable packCurveFlash PROGMEM = packCurve;
+
+/*****************************************************************
+  * Function name: thermistorCentidegrees
+  * Function inputs: unsigned int code, a 10 bit ADC reading
+  * Function outputs: int16_t, temperature in hundredths of a degree
+  * Function description: linearizes the pack thermistor through
+  *                       the flash table
+  * Author(s): Leonard Shin, Leika Yamada
+  *****************************************************************/
+int16_t thermistorCentidegrees ( unsigned int code ) {
+
+    return thermistorLookup(&packCurveFlash, code);
+}
+
+/*****************************************************************
+  * Function name: thermistorTemperature
+  * Function inputs: unsigned int code, a 10 bit ADC reading
+  * Function outputs: float, temperature in degrees Celsius
+  * Function description: thermistorCentidegrees for the float
+  *                       measurement path
+  * Author(s): Leonard Shin, Leika Yamada
+  *****************************************************************/
+float thermistorTemperature ( unsigned int code ) {
+
+    return thermistorCentidegrees(code) * 0.01f;
+}
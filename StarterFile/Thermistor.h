@@ -0,0 +1,140 @@
+#ifndef THERMISTOR_H_
+#define THERMISTOR_H_
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+
+/* NTC thermistor linearization. The thermistor sits between the ADC input
+ * and ground with THERMISTOR_SERIES from the input to the reference, so a
+ * 10 bit code reads R = SERIES * code / (1024 - code). The curve from code
+ * to temperature is worked out by the compiler from the sensor's beta or
+ * Steinhart-Hart coefficients into a table of THERMISTOR_SEGMENTS + 1
+ * temperatures, one every 1 << THERMISTOR_SHIFT codes, kept in flash. A
+ * reading is two flash words and a 16 by 8 bit interpolation, against a
+ * float log() and division of the exact formula.
+ * Temperatures are in hundredths of a degree Celsius, clamped to
+ * THERMISTOR_MIN and THERMISTOR_MAX at the ends of the range where the
+ * divider no longer resolves them; see Host/ThermistorBench.cpp for the
+ * error against the exact formula.*/
+#define THERMISTOR_R0           10000.0         // Ohm at THERMISTOR_T0
+#define THERMISTOR_T0           25.0            // Celsius
+#define THERMISTOR_BETA         3950.0          // Kelvin, 25/85 C
+#define THERMISTOR_SERIES       10000.0         // Ohm, ADC input to the reference
+#define THERMISTOR_CODES        1024            // 10 bit ADC
+#define THERMISTOR_SHIFT        3               // Codes per table segment are 1 << THERMISTOR_SHIFT
+#define THERMISTOR_SEGMENTS     ( THERMISTOR_CODES >> THERMISTOR_SHIFT )
+#define THERMISTOR_MIN          -5500           // Centidegrees, an open sensor reads this
+#define THERMISTOR_MAX          15000           // Centidegrees, a shorted sensor reads this
+#define KELVIN_OFFSET           273.15
+
+
+#ifdef __cplusplus
+
+/* Steinhart-Hart form of a thermistor: 1 / T = a + b ln R + c (ln R)^3, T in
+ * Kelvin. A beta sensor is the same with c = 0.*/
+struct thermistorModel {
+    double a;
+    double b;
+    double c;
+    double series;                      // Ohm, ADC input to the reference
+};
+
+struct thermistorTable {
+    int16_t centi[THERMISTOR_SEGMENTS + 1];     // Centidegrees at code segment << THERMISTOR_SHIFT
+};
+
+/* Natural log for constant expressions, <math.h> has none. x is brought
+ * into [1, 2) by halving or doubling, then ln x = 2 atanh((x - 1) / (x + 1))
+ * whose series converges quickly for |y| <= 1/3.*/
+constexpr double thermistorLn2 = 0.693147180559945309;
+
+constexpr double thermistorAtanh ( double y, double y2, double power, int k ) {
+    return k > 41 ? 0.0 : power / k + thermistorAtanh(y, y2, power * y2, k + 2);
+}
+
+constexpr double thermistorLog ( double x, int twos = 0 ) {
+    return x >= 2.0 ? thermistorLog(x / 2.0, twos + 1)
+         : x < 1.0 ? thermistorLog(x * 2.0, twos - 1)
+         : twos * thermistorLn2
+           + 2.0 * thermistorAtanh(( x - 1.0 ) / ( x + 1.0 ), ( ( x - 1.0 ) / ( x + 1.0 ) ) * ( ( x - 1.0 ) / ( x + 1.0 ) ),
+                                   ( x - 1.0 ) / ( x + 1.0 ), 1);
+}
+
+constexpr thermistorModel thermistorBeta ( double r0, double t0, double beta, double series ) {
+    return thermistorModel{ 1.0 / ( t0 + KELVIN_OFFSET ) - thermistorLog(r0) / beta, 1.0 / beta, 0.0, series };
+}
+
+constexpr thermistorModel thermistorSteinhartHart ( double a, double b, double c, double series ) {
+    return thermistorModel{ a, b, c, series };
+}
+
+constexpr double thermistorCelsius ( const thermistorModel& model, double lnR ) {
+    return 1.0 / ( model.a + model.b * lnR + model.c * lnR * lnR * lnR ) - KELVIN_OFFSET;
+}
+
+constexpr int16_t thermistorRound ( double centi ) {
+    return centi <= THERMISTOR_MIN ? THERMISTOR_MIN
+         : centi >= THERMISTOR_MAX ? THERMISTOR_MAX
+         : (int16_t) ( centi < 0 ? centi - 0.5 : centi + 0.5 );
+}
+
+/* Table entry of one code: code 0 is a shorted sensor, the last entry
+ * (code THERMISTOR_CODES, never read) an open one*/
+constexpr int16_t thermistorEntry ( const thermistorModel& model, unsigned int code ) {
+    return code == 0 ? THERMISTOR_MAX
+         : code >= THERMISTOR_CODES ? THERMISTOR_MIN
+         : thermistorRound(100.0 * thermistorCelsius(model,
+               thermistorLog(model.series * code / ( THERMISTOR_CODES - code ))));
+}
+
+/* 0, 1, ... N - 1 as a parameter pack, so the table is one brace list*/
+template <unsigned int... I> struct thermistorIndices {};
+template <unsigned int N, unsigned int... I>
+struct thermistorSequence : thermistorSequence<N - 1, N - 1, I...> {};
+template <unsigned int... I>
+struct thermistorSequence<0, I...> {
+    typedef thermistorIndices<I...> type;
+};
+
+template <unsigned int... I>
+constexpr thermistorTable thermistorTableOf ( const thermistorModel& model, thermistorIndices<I...> ) {
+    return thermistorTable{ { thermistorEntry(model, I << THERMISTOR_SHIFT)... } };
+}
+
+constexpr thermistorTable makeThermistorTable ( const thermistorModel& model ) {
+    return thermistorTableOf(model, thermistorSequence<THERMISTOR_SEGMENTS + 1>::type());
+}
+
+/* Reads table, in flash, at code. The product of the segment's rise and the
+ * offset into it needs 32 bits only at the clamped ends.*/
+static inline int16_t thermistorLookup ( const thermistorTable* table, unsigned int code ) {
+    if( code >= THERMISTOR_CODES ){
+        return THERMISTOR_MIN;
+    }
+    unsigned int segment = code >> THERMISTOR_SHIFT;
+    uint8_t offset = code & ( ( 1 << THERMISTOR_SHIFT ) - 1 );
+    int16_t low = (int16_t) pgm_read_word(&table->centi[segment]);
+    int16_t high = (int16_t) pgm_read_word(&table->centi[segment + 1]);
+    return low + (int16_t) ( ( (int32_t) ( high - low ) * offset + ( 1 << ( THERMISTOR_SHIFT - 1 ) ) ) >> THERMISTOR_SHIFT );
+}
+
+#endif    // __cplusplus
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int16_t thermistorCentidegrees (unsigned int code);    // Pack thermistor at a 10 bit ADC code, in hundredths of a degree
+float thermistorTemperature (unsigned int code);        // The same in degrees Celsius
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif